@@ -10,11 +10,21 @@
 #ifndef COROUTINE_CHANNEL_HPP
 #define COROUTINE_CHANNEL_HPP
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <mutex>
+#include <optional>
+#include <system_error>
 #include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <coroutine/frame.h>
+#include <coroutine/suspend.h>
+#include <gsl/gsl>
 
 namespace internal
 {
@@ -61,26 +71,189 @@ class list
 
         return node; // this can be nullptr
     }
+    // - Note
+    //      Remove the node. Linear search.
+    //      Return `false` if it is not in the list
+    bool erase(node_t* node) noexcept(false)
+    {
+        node_t* prev = nullptr;
+        for (node_t* it = head; it != nullptr; it = it->next)
+        {
+            if (it == node)
+            {
+                if (prev)
+                    prev->next = it->next;
+                else
+                    head = it->next;
+                if (tail == it)
+                    tail = prev;
+                return true;
+            }
+            if (it == tail)
+                break;
+            prev = it;
+        }
+        return false;
+    }
+};
+
+// - Note
+//      Shared by the waiters of one `select`.
+//      The first one to claim it completes the `select`,
+//      and the others become stale.
+//      Timed waiters use it to race with their timer
+class select_token
+{
+    std::atomic<void*> winner{};
+    // timer of `read_for`, `write_for`. `nullptr` if not
+    timer_wheel* wheel = nullptr;
+    timer_node* timer = nullptr;
+
+  public:
+    select_token() noexcept = default;
+    select_token(timer_wheel& w, timer_node& t) noexcept
+        : wheel{std::addressof(w)}, timer{std::addressof(t)}
+    {
+    }
+
+  public:
+    bool try_claim(void* node) noexcept
+    {
+        void* expected = nullptr;
+        return winner.compare_exchange_strong(expected, node,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire);
+    }
+    void* get() const noexcept
+    {
+        return winner.load(std::memory_order_acquire);
+    }
+    // - Note
+    //      Cancel the timer after the claim. `false` if it already expired.
+    //      Then the timer resumes the waiter, and the claimer must not
+    bool try_disarm() noexcept
+    {
+        return wheel == nullptr || wheel->cancel(*timer);
+    }
+};
+
+// - Note
+//      Type erased lock of a channel in `select`
+struct select_lock
+{
+    const void* key; // address to sort the locks
+    void* lockable;
+    void (*lock)(void*);
+    void (*unlock)(void*);
+
+    template <typename Lockable>
+    static select_lock make(Lockable& mtx) noexcept
+    {
+        return select_lock{
+            std::addressof(mtx), std::addressof(mtx),
+            [](void* p) { static_cast<Lockable*>(p)->lock(); },
+            [](void* p) { static_cast<Lockable*>(p)->unlock(); }};
+    }
+};
+
+// - Note
+//      Fixed size ring of values for `buffered_channel`
+template <typename T, size_t N>
+class ring
+{
+    std::array<T, N> storage{};
+    size_t begin = 0;
+    size_t count = 0;
+
+  public:
+    bool is_empty() const noexcept
+    {
+        return count == 0;
+    }
+    bool is_full() const noexcept
+    {
+        return count == N;
+    }
+    void push(T&& value) noexcept(false)
+    {
+        storage[(begin + count) % N] = std::move(value);
+        ++count;
+    }
+    void pop(T& value) noexcept(false)
+    {
+        value = std::move(storage[begin]);
+        begin = (begin + 1) % N;
+        --count;
+    }
 };
 } // namespace internal
 
-template <typename T, typename Lockable>
+// - Note
+//      Resumption policy of `channel`.
+//      Resume the partner in the current thread
+struct resume_inline final
+{
+    void operator()(std::experimental::coroutine_handle<void> rh) const
+        noexcept(false)
+    {
+        rh.resume();
+    }
+};
+
+// - Note
+//      Resumption policy of `channel`.
+//      Post the partner to the executor which has `push(coroutine_handle)`.
+//      For example, `suspend_queue` or `thread_pool`.
+//      It prevents the nested resumes of long pipelines
+template <typename Executor>
+class resume_on final
+{
+    Executor* ex;
+
+  public:
+    explicit resume_on(Executor& e) noexcept : ex{std::addressof(e)}
+    {
+    }
+    void operator()(std::experimental::coroutine_handle<void> rh) const
+        noexcept(false)
+    {
+        ex->push(rh);
+    }
+};
+
+template <typename T, typename Lockable, typename Resume = resume_inline>
 class channel;
-template <typename T, typename Lockable>
+template <typename T, typename Lockable, typename Resume>
 class reader;
-template <typename T, typename Lockable>
+template <typename T, typename Lockable, typename Resume>
 class writer;
+template <typename T, typename Lockable, typename Resume>
+class select_read;
+template <typename T, typename Lockable, typename Resume>
+class select_write;
+template <typename T, typename Lockable, typename Resume>
+class batch_reader;
+template <typename T, typename Lockable, typename Resume>
+class batch_writer;
+template <typename T, typename Lockable, typename Resume>
+class direct_reader;
+template <typename T, typename Lockable, typename Resume>
+class emplace_writer;
+template <typename T, typename Lockable, typename Resume>
+class timed_reader;
+template <typename T, typename Lockable, typename Resume>
+class timed_writer;
 
 // - Note
 //      Awaitable reader for `channel`
-template <typename T, typename Lockable>
+template <typename T, typename Lockable, typename Resume>
 class reader final
 {
   public:
     using value_type = T;
     using pointer = T*;
     using reference = T&;
-    using channel_type = channel<T, Lockable>;
+    using channel_type = channel<T, Lockable, Resume>;
 
     template <typename P>
     using coroutine_handle = typename std::experimental::coroutine_handle<P>;
@@ -93,38 +266,63 @@ class reader final
     friend channel_type;
     friend writer;
     friend reader_list;
+    friend select_read<T, Lockable, Resume>;
+    friend batch_reader<T, Lockable, Resume>;
+    friend direct_reader<T, Lockable, Resume>;
+    friend timed_reader<T, Lockable, Resume>;
 
   private:
-    mutable pointer ptr; // Address of value
-    mutable void* frame; // Resumeable Handle
+    mutable value_type value; // Received value if `ptr` is not given
+    mutable pointer ptr;      // Address to receive. The writer moves to it
+    mutable void* frame;      // Resumeable Handle
     union {
         reader* next = nullptr; // Next reader in channel
         channel_type* chan;     // Channel to push this reader
     };
+    // `select` which owns this. `nullptr` if not
+    internal::select_token* token = nullptr;
+    // Capacity of `ptr`, then num of received values
+    mutable size_t count = 1;
 
   private:
-    explicit reader(channel_type& ch) noexcept(false)
-        : ptr{}, frame{nullptr}, chan{std::addressof(ch)}
+    explicit reader(channel_type& ch, pointer dst = nullptr) noexcept(false)
+        : value{}, ptr{dst}, frame{nullptr}, chan{std::addressof(ch)}
     {
     }
     reader(const reader&) noexcept(false) = delete;
     reader& operator=(const reader&) noexcept(false) = delete;
 
   public:
+    // - Note
+    //      The members are swapped. Initialize them,
+    //      so the moved-from one doesn't hold garbage
     reader(reader&& rhs) noexcept(false)
+        : value{}, ptr{nullptr}, frame{nullptr}, chan{nullptr}
     {
+        std::swap(this->value, rhs.value);
         std::swap(this->ptr, rhs.ptr);
         std::swap(this->frame, rhs.frame);
         std::swap(this->chan, rhs.chan);
+        std::swap(this->token, rhs.token);
+        std::swap(this->count, rhs.count);
     }
     reader& operator=(reader&& rhs) noexcept(false)
     {
+        std::swap(this->value, rhs.value);
         std::swap(this->ptr, rhs.ptr);
         std::swap(this->frame, rhs.frame);
         std::swap(this->chan, rhs.chan);
+        std::swap(this->token, rhs.token);
+        std::swap(this->count, rhs.count);
         return *this;
     }
 
+  private:
+    // - Note
+    //      Resume the partner if it is not resumed yet.
+    //      Return `false` if the channel is closed
+    bool complete() noexcept(false);
+
   public:
     bool await_ready() const noexcept(false);
     void await_suspend(coroutine_handle<void> rh) noexcept(false);
@@ -133,14 +331,14 @@ class reader final
 
 // - Note
 //      Awaitable writer for `channel`
-template <typename T, typename Lockable>
+template <typename T, typename Lockable, typename Resume>
 class writer final
 {
   public:
     using value_type = T;
     using pointer = T*;
     using reference = T&;
-    using channel_type = channel<T, Lockable>;
+    using channel_type = channel<T, Lockable, Resume>;
 
     template <typename P>
     using coroutine_handle = typename std::experimental::coroutine_handle<P>;
@@ -153,6 +351,10 @@ class writer final
     friend channel_type;
     friend reader;
     friend writer_list;
+    friend select_write<T, Lockable, Resume>;
+    friend batch_writer<T, Lockable, Resume>;
+    friend emplace_writer<T, Lockable, Resume>;
+    friend timed_writer<T, Lockable, Resume>;
 
   private:
     mutable pointer ptr; // Address of value
@@ -161,6 +363,10 @@ class writer final
         writer* next = nullptr; // Next writer in channel
         channel_type* chan;     // Channel to push this writer
     };
+    // `select` which owns this. `nullptr` if not
+    internal::select_token* token = nullptr;
+    // Num of values at `ptr`, then num of taken values
+    mutable size_t count = 1;
 
   private:
     explicit writer(channel_type& ch, pointer pv) noexcept(false)
@@ -171,17 +377,24 @@ class writer final
     writer& operator=(const writer&) noexcept(false) = delete;
 
   public:
+    // - Note
+    //      See `reader(reader&&)`
     writer(writer&& rhs) noexcept(false)
+        : ptr{nullptr}, frame{nullptr}, chan{nullptr}
     {
         std::swap(this->ptr, rhs.ptr);
         std::swap(this->frame, rhs.frame);
         std::swap(this->chan, rhs.chan);
+        std::swap(this->token, rhs.token);
+        std::swap(this->count, rhs.count);
     }
     writer& operator=(writer&& rhs) noexcept(false)
     {
         std::swap(this->ptr, rhs.ptr);
         std::swap(this->frame, rhs.frame);
         std::swap(this->chan, rhs.chan);
+        std::swap(this->token, rhs.token);
+        std::swap(this->count, rhs.count);
         return *this;
     }
 
@@ -194,9 +407,9 @@ class writer final
 // - Note
 //      Coroutine Channel
 //      Channel doesn't support Copy, Move
-template <typename T, typename Lockable>
-class channel final : internal::list<reader<T, Lockable>>,
-                      internal::list<writer<T, Lockable>>
+template <typename T, typename Lockable, typename Resume>
+class channel final : internal::list<reader<T, Lockable, Resume>>,
+                      internal::list<writer<T, Lockable, Resume>>
 {
     static_assert(std::is_reference<T>::value == false,
                   "Using reference for channel is forbidden.");
@@ -210,22 +423,38 @@ class channel final : internal::list<reader<T, Lockable>>,
     using reference = value_type&;
 
     using mutex_t = Lockable;
+    using resume_t = Resume;
 
   private:
-    using reader = reader<value_type, mutex_t>;
+    using reader = reader<value_type, mutex_t, Resume>;
     using reader_list = internal::list<reader>;
 
-    using writer = writer<value_type, mutex_t>;
+    using writer = writer<value_type, mutex_t, Resume>;
     using writer_list = internal::list<writer>;
 
     friend reader;
     friend writer;
+    friend select_read<T, Lockable, Resume>;
+    friend select_write<T, Lockable, Resume>;
+    friend batch_reader<T, Lockable, Resume>;
+    friend batch_writer<T, Lockable, Resume>;
+    friend direct_reader<T, Lockable, Resume>;
+    friend emplace_writer<T, Lockable, Resume>;
+    friend timed_reader<T, Lockable, Resume>;
+    friend timed_writer<T, Lockable, Resume>;
 
   private:
     mutex_t mtx{};
+    bool closed = false;
+    resume_t resume;
 
   public:
-    channel() noexcept(false) : reader_list{}, writer_list{}, mtx{}
+    channel() noexcept(false)
+        : reader_list{}, writer_list{}, mtx{}, resume{}
+    {
+    }
+    explicit channel(resume_t policy) noexcept(false)
+        : reader_list{}, writer_list{}, mtx{}, resume{policy}
     {
     }
     channel(const channel&) noexcept(false) = delete;
@@ -236,43 +465,184 @@ class channel final : internal::list<reader<T, Lockable>>,
 
     ~channel() noexcept(false)
     {
-        writer_list& writers = *this;
-        reader_list& readers = *this;
-
-        //
-        // Because of thread scheduling,
-        // Some coroutines can be enqueued into list just after
-        // this destructor unlocks.
-        //
-        // But this can't be detected at once since
-        // we have 2 list in the channel...
-        //
-        // Current implementation triggers scheduling repeatedly
-        // to reduce the possibility. As repeat count becomes greater,
-        // the possibility drops to zero. But notice that it is NOT zero.
-        //
-        size_t repeat = 1; // recommend 5'000+ repeat for hazard usage
-        do
+        // waiters which come after this complete immediately
+        close();
+    }
+
+  public:
+    // - Note
+    //      Close the channel.
+    //      All waiting and future reads/writes complete with `false`.
+    //      The waiters are resumed after unlock. Close again does nothing
+    void close() noexcept(false)
+    {
+        reader_list readers{};
+        writer_list writers{};
         {
             std::unique_lock lck{this->mtx};
+            if (closed)
+                return;
+            closed = true;
 
-            while (writers.is_empty() == false)
-            {
-                writer* w = writers.pop();
-                auto rh = coroutine_handle<void>::from_address(w->frame);
-                w->frame = internal::poison();
+            // detach the waiters.
+            // the ones without frame are resumed by their timer
+            while (writer* w = claim<writer>(*this))
+                if (w->frame)
+                    writers.push(w);
+                else
+                    w->frame = internal::poison();
+            while (reader* r = claim<reader>(*this))
+                if (r->frame)
+                    readers.push(r);
+                else
+                    r->frame = internal::poison();
+        }
+        cancel(writers);
+        cancel(readers);
+    }
 
-                rh.resume();
-            }
-            while (readers.is_empty() == false)
-            {
-                reader* r = readers.pop();
-                auto rh = coroutine_handle<void>::from_address(r->frame);
-                r->frame = internal::poison();
+  private:
+    // - Note
+    //      Pop a waiter. The waiters of `select` which is
+    //      completed by the other case are dropped.
+    //      If the timer of the waiter already expired, its frame is cleared
+    //      so the partner doesn't resume it.
+    //      The lock must be held
+    template <typename Node>
+    static auto claim(internal::list<Node>& nodes) noexcept(false) -> Node*
+    {
+        while (nodes.is_empty() == false)
+        {
+            Node* node = nodes.pop();
+            if (node->token == nullptr)
+                return node;
+            if (node->token->try_claim(node) == false)
+                continue;
+            if (node->token->try_disarm() == false)
+                node->frame = nullptr;
+            return node;
+        }
+        return nullptr;
+    }
+    // - Note
+    //      Resume the detached waiters with poison
+    template <typename Node>
+    void cancel(internal::list<Node>& nodes) noexcept(false)
+    {
+        while (Node* node = nodes.pop())
+        {
+            auto rh = coroutine_handle<void>::from_address(node->frame);
+            node->frame = internal::poison();
 
-                rh.resume();
-            }
-        } while (repeat--);
+            resume(rh);
+        }
+    }
+    // - Note
+    //      Resume the partners of batch operation
+    template <typename Node>
+    void resume_all(internal::list<Node>& nodes) noexcept(false)
+    {
+        while (Node* node = nodes.pop())
+        {
+            auto rh = coroutine_handle<void>::from_address(node->frame);
+            node->frame = nullptr;
+
+            resume(rh);
+        }
+    }
+
+    // - Note
+    //      Take the value of a waiting writer and its resumeable_handle.
+    //      The value is moved before the writer resumes,
+    //      so any resumption policy is safe.
+    //      If closed, the reader gets poison instead.
+    //      The lock must be held
+    bool pair(const reader& r) noexcept(false)
+    {
+        if (closed)
+        {
+            r.frame = internal::poison();
+            return true;
+        }
+        writer* w = claim<writer>(*this);
+        if (w == nullptr)
+            return false;
+
+        assert(w->ptr != nullptr);
+        *r.ptr = std::move(*w->ptr);
+        w->count = 1; // it can be a `batch_writer`
+        std::swap(r.frame, w->frame);
+        return true;
+    }
+    // - Note
+    //      Give the value to a waiting reader and take its handle.
+    //      If closed, the writer gets poison instead.
+    //      The lock must be held
+    bool pair(const writer& w) noexcept(false)
+    {
+        if (closed)
+        {
+            w.frame = internal::poison();
+            return true;
+        }
+        reader* r = claim<reader>(*this);
+        if (r == nullptr)
+            return false;
+
+        *r->ptr = std::move(*w.ptr);
+        r->count = 1; // it can be a `batch_reader`
+        std::swap(w.frame, r->frame);
+        return true;
+    }
+
+    // - Note
+    //      Give values to the waiting readers as many as possible.
+    //      The readers are moved to `partners` to resume after unlock.
+    //      The lock must be held
+    size_t give_n(pointer values, size_t count,
+                  reader_list& partners) noexcept(false)
+    {
+        size_t i = 0;
+        while (i < count)
+        {
+            reader* r = claim<reader>(*this);
+            if (r == nullptr)
+                break;
+
+            // move as it can hold
+            const auto n = std::min(count - i, r->count);
+            std::move(values + i, values + i + n, r->ptr);
+            r->count = n;
+            i += n;
+
+            if (r->frame) // see `claim`
+                partners.push(r);
+        }
+        return i;
+    }
+    // - Note
+    //      Take values from the waiting writers as many as possible.
+    //      The writers are moved to `partners` to resume after unlock.
+    //      The lock must be held
+    size_t take_n(pointer values, size_t count,
+                  writer_list& partners) noexcept(false)
+    {
+        size_t i = 0;
+        while (i < count)
+        {
+            writer* w = claim<writer>(*this);
+            if (w == nullptr)
+                break;
+
+            const auto n = std::min(count - i, w->count);
+            std::move(w->ptr, w->ptr + n, values + i);
+            w->count = n;
+            i += n;
+
+            if (w->frame) // see `claim`
+                partners.push(w);
+        }
+        return i;
     }
 
   public:
@@ -284,36 +654,124 @@ class channel final : internal::list<reader<T, Lockable>>,
         return writer{*this, std::addressof(ref)};
     }
     // - Note
+    //      Awaitable write of temporary value.
+    //      The temporary lives until the end of `co_await` expression,
+    //      so don't store the awaitable
+    decltype(auto) write(value_type&& value) noexcept(false)
+    {
+        return writer{*this, std::addressof(value)};
+    }
+    // - Note
+    //      Awaitable write of the value constructed in the awaitable.
+    //      `co_await` returns `false` if the channel is closed
+    template <typename... Args>
+    decltype(auto) emplace(Args&&... args) noexcept(false)
+    {
+        return emplace_writer<value_type, mutex_t, Resume>{
+            *this, std::forward<Args>(args)...};
+    }
+    // - Note
     //      Awaitable read.
     //      `reader` type implements the awaitable concept
     decltype(auto) read() noexcept(false)
     {
         return reader{*this};
     }
+    // - Note
+    //      Awaitable read to the reference.
+    //      The writer moves the value to it directly.
+    //      `co_await` returns `false` if the channel is closed
+    decltype(auto) read_into(reference ref) noexcept(false)
+    {
+        return direct_reader<value_type, mutex_t, Resume>{*this, ref};
+    }
+    // - Note
+    //      Awaitable read with timeout.
+    //      The timer wheel resumes the reader on expiry,
+    //      so it must be driven by `timer_wheel::expire`.
+    //      `co_await` returns the value and `channel_status`
+    decltype(auto) read_for(timer_wheel::duration d,
+                            timer_wheel& wheel) noexcept(false)
+    {
+        return timed_reader<value_type, mutex_t, Resume>{
+            *this, wheel, timer_wheel::clock_type::now() + d};
+    }
+    // - Note
+    //      Awaitable write with timeout. See `read_for`.
+    //      `co_await` returns `channel_status`
+    decltype(auto) write_for(reference ref, timer_wheel::duration d,
+                             timer_wheel& wheel) noexcept(false)
+    {
+        return timed_writer<value_type, mutex_t, Resume>{
+            *this, ref, wheel, timer_wheel::clock_type::now() + d};
+    }
+    // - Note
+    //      Awaitable batch write.
+    //      Give the values to the waiting readers under one lock.
+    //      If there is none, wait for a reader.
+    //      `co_await` returns the number of written values.
+    //      The values must be alive until it returns
+    decltype(auto) write_n(gsl::span<value_type> values) noexcept(false)
+    {
+        return batch_writer<value_type, mutex_t, Resume>{*this, values};
+    }
+    // - Note
+    //      Awaitable batch read.
+    //      Take values from the waiting writers under one lock.
+    //      If there is none, wait for a writer.
+    //      `co_await` returns the number of read values
+    decltype(auto) read_n(gsl::span<value_type> values) noexcept(false)
+    {
+        return batch_reader<value_type, mutex_t, Resume>{*this, values};
+    }
+
+    // - Note
+    //      Read only if a writer is waiting. Never suspends.
+    //      The writer is resumed before return
+    auto try_read() noexcept(false) -> std::optional<value_type>
+    {
+        value_type value{};
+        writer_list partners{};
+        {
+            std::unique_lock lck{mtx};
+            if (closed || take_n(std::addressof(value), 1, partners) == 0)
+                return std::nullopt;
+        }
+        resume_all(partners);
+        return value;
+    }
+    // - Note
+    //      Write only if a reader is waiting. Never suspends.
+    //      The reader is resumed before return
+    bool try_write(reference ref) noexcept(false)
+    {
+        reader_list partners{};
+        {
+            std::unique_lock lck{mtx};
+            if (closed || give_n(std::addressof(ref), 1, partners) == 0)
+                return false;
+        }
+        resume_all(partners);
+        return true;
+    }
 };
 
-template <typename T, typename M>
-bool reader<T, M>::await_ready() const noexcept(false)
+template <typename T, typename M, typename R>
+bool reader<T, M, R>::await_ready() const noexcept(false)
 {
+    if (this->ptr == nullptr)
+        this->ptr = std::addressof(this->value);
+
     chan->mtx.lock();
-    if (chan->writer_list::is_empty())
+    if (chan->pair(*this) == false)
         return false;
 
-    writer* w = chan->writer_list::pop();
-    assert(w != nullptr);
-    assert(w->ptr != nullptr);
-    assert(w->frame != nullptr);
-
-    // exchange address & resumeable_handle
-    std::swap(this->ptr, w->ptr);
-    std::swap(this->frame, w->frame);
-
     chan->mtx.unlock();
     return true;
 }
 
-template <typename T, typename M>
-void reader<T, M>::await_suspend(coroutine_handle<void> coro) noexcept(false)
+template <typename T, typename M, typename R>
+void reader<T, M, R>::await_suspend(coroutine_handle<void> coro) noexcept(false)
 {
     // notice that next & chan are sharing memory
     channel_type& ch = *(this->chan);
@@ -325,45 +783,48 @@ void reader<T, M>::await_suspend(coroutine_handle<void> coro) noexcept(false)
     ch.mtx.unlock();
 }
 
-template <typename T, typename M>
-auto reader<T, M>::await_resume() noexcept(false)
-    -> std::tuple<value_type, bool>
+template <typename T, typename M, typename R>
+bool reader<T, M, R>::complete() noexcept(false)
 {
-    // frame holds poision if the channel is going to destroy
+    // frame holds poision if the channel is closed
     if (this->frame == internal::poison())
-        return std::make_tuple(value_type{}, false);
+        return false;
 
-    // Store first. we have to do this
-    // because the resume operation can destroy the writer coroutine
-    value_type value = std::move(*ptr);
+    // the writer already moved the value to `ptr`.
+    // the frame is not null only if this didn't suspend,
+    // so `chan` is still valid
     if (auto rh = coroutine_handle<void>::from_address(frame))
     {
-        assert(this->frame != nullptr);
         assert(*reinterpret_cast<uint64_t*>(frame) != 0);
-        rh.resume();
+        this->frame = nullptr;
+        chan->resume(rh);
     }
+    return true;
+}
+
+template <typename T, typename M, typename R>
+auto reader<T, M, R>::await_resume() noexcept(false)
+    -> std::tuple<value_type, bool>
+{
+    if (complete() == false)
+        return std::make_tuple(value_type{}, false);
 
-    return std::make_tuple(std::move(value), true);
+    return std::make_tuple(std::move(*ptr), true);
 }
 
-template <typename T, typename M>
-bool writer<T, M>::await_ready() const noexcept(false)
+template <typename T, typename M, typename R>
+bool writer<T, M, R>::await_ready() const noexcept(false)
 {
     chan->mtx.lock();
-    if (chan->reader_list::is_empty())
+    if (chan->pair(*this) == false)
         return false;
 
-    reader* r = chan->reader_list::pop();
-    // exchange address & resumeable_handle
-    std::swap(this->ptr, r->ptr);
-    std::swap(this->frame, r->frame);
-
     chan->mtx.unlock();
     return true;
 }
 
-template <typename T, typename M>
-void writer<T, M>::await_suspend(coroutine_handle<void> coro) noexcept(false)
+template <typename T, typename M, typename R>
+void writer<T, M, R>::await_suspend(coroutine_handle<void> coro) noexcept(false)
 {
     // notice that next & chan are sharing memory
     channel_type& ch = *(this->chan);
@@ -375,20 +836,2038 @@ void writer<T, M>::await_suspend(coroutine_handle<void> coro) noexcept(false)
     ch.mtx.unlock();
 }
 
-template <typename T, typename M>
-bool writer<T, M>::await_resume() noexcept(false)
+template <typename T, typename M, typename R>
+bool writer<T, M, R>::await_resume() noexcept(false)
 {
-    // frame holds poision if the channel is going to destroy
+    // frame holds poision if the channel is closed
     if (this->frame == internal::poison())
         return false;
 
+    // see `reader::await_resume`
     if (auto rh = coroutine_handle<void>::from_address(frame))
     {
-        assert(this->frame != nullptr);
         assert(*reinterpret_cast<uint64_t*>(frame) != 0);
-        rh.resume();
+        this->frame = nullptr;
+        chan->resume(rh);
     }
     return true;
 }
 
+// - Note
+//      Awaitable reader for `channel::read_into`.
+//      The writer moves the value to the reference, so it is moved once
+template <typename T, typename Lockable, typename Resume>
+class direct_reader final
+{
+  public:
+    using value_type = T;
+    using reference = T&;
+    using channel_type = channel<T, Lockable, Resume>;
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  private:
+    using reader = reader<T, Lockable, Resume>;
+
+  private:
+    reader node;
+
+  public:
+    direct_reader(channel_type& ch, reference ref) noexcept(false)
+        : node{ch, std::addressof(ref)}
+    {
+    }
+
+  public:
+    bool await_ready() const noexcept(false)
+    {
+        return node.await_ready();
+    }
+    void await_suspend(coroutine_handle<void> coro) noexcept(false)
+    {
+        return node.await_suspend(coro);
+    }
+    bool await_resume() noexcept(false)
+    {
+        return node.complete();
+    }
+};
+
+// - Note
+//      Awaitable writer for `channel::emplace`.
+//      The value is constructed in this awaitable, so it can't be moved
+template <typename T, typename Lockable, typename Resume>
+class emplace_writer final
+{
+  public:
+    using value_type = T;
+    using channel_type = channel<T, Lockable, Resume>;
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  private:
+    using writer = writer<T, Lockable, Resume>;
+
+  private:
+    value_type value;
+    writer node;
+
+  public:
+    template <typename... Args>
+    explicit emplace_writer(channel_type& ch, Args&&... args) noexcept(false)
+        : value(std::forward<Args>(args)...), node{ch, std::addressof(value)}
+    {
+    }
+    emplace_writer(const emplace_writer&) = delete;
+    emplace_writer(emplace_writer&&) = delete;
+    emplace_writer& operator=(const emplace_writer&) = delete;
+    emplace_writer& operator=(emplace_writer&&) = delete;
+
+  public:
+    bool await_ready() const noexcept(false)
+    {
+        return node.await_ready();
+    }
+    void await_suspend(coroutine_handle<void> coro) noexcept(false)
+    {
+        return node.await_suspend(coro);
+    }
+    bool await_resume() noexcept(false)
+    {
+        return node.await_resume();
+    }
+};
+
+// - Note
+//      Result of `channel::read_for`, `channel::write_for`
+enum class channel_status : uint32_t
+{
+    success = 0,
+    closed = 1,
+    timeout = 2, // the waiter is withdrawn from the channel
+};
+
+// - Note
+//      Awaitable reader for `channel::read_for`.
+//      The waiter is in the channel and the timer wheel at once,
+//      and the first one to claim the token completes it.
+//      See `internal::select_token::try_disarm`
+template <typename T, typename Lockable, typename Resume>
+class timed_reader final
+{
+  public:
+    using value_type = T;
+    using channel_type = channel<T, Lockable, Resume>;
+    using time_point = timer_wheel::time_point;
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  private:
+    using reader = reader<T, Lockable, Resume>;
+
+  private:
+    reader node;
+    channel_type* chan;
+    timer_wheel* wheel;
+    time_point until;
+    timer_node timer{};
+    internal::select_token token;
+    bool suspended = false;
+    bool expired = false;
+
+  public:
+    timed_reader(channel_type& ch, timer_wheel& w, time_point tp) noexcept(
+        false)
+        : node{ch}, chan{std::addressof(ch)}, wheel{std::addressof(w)},
+          until{tp}, token{w, timer}
+    {
+    }
+    // - Note
+    //      The frame can be destroyed while it is suspended.
+    //      Withdraw from the channel and the wheel like the expiry
+    ~timed_reader() noexcept(false)
+    {
+        if (suspended == false)
+            return;
+        std::unique_lock lck{chan->mtx};
+        if (token.try_claim(std::addressof(node)))
+        {
+            chan->reader_list::erase(std::addressof(node));
+            wheel->cancel(timer);
+        }
+    }
+    timed_reader(const timed_reader&) = delete;
+    timed_reader(timed_reader&&) = delete;
+    timed_reader& operator=(const timed_reader&) = delete;
+    timed_reader& operator=(timed_reader&&) = delete;
+
+  public:
+    bool await_ready() noexcept(false)
+    {
+        node.ptr = std::addressof(node.value);
+
+        chan->mtx.lock();
+        if (chan->pair(node) == false)
+        {
+            if (timer_wheel::clock_type::now() < until)
+                return false; // keep the lock until the suspension
+            expired = true;
+        }
+        chan->mtx.unlock();
+        return true;
+    }
+    void await_suspend(coroutine_handle<void> coro) noexcept(false)
+    {
+        channel_type& ch = *chan;
+        suspended = true;
+
+        node.frame = coro.address();
+        node.token = std::addressof(token);
+        node.next = nullptr;
+        ch.reader_list::push(std::addressof(node));
+        // the token is claimed under the lock. so the timer must be
+        // inserted before unlock
+        wheel->insert(timer, until, coro);
+        ch.mtx.unlock();
+    }
+    auto await_resume() noexcept(false)
+        -> std::tuple<value_type, channel_status>
+    {
+        if (suspended)
+        {
+            // the partner moves the value under the lock
+            std::unique_lock lck{chan->mtx};
+            if (token.try_claim(std::addressof(node)))
+            {
+                chan->reader_list::erase(std::addressof(node));
+                expired = true;
+            }
+        }
+        if (expired)
+            return std::make_tuple(value_type{}, channel_status::timeout);
+        if (node.complete() == false)
+            return std::make_tuple(value_type{}, channel_status::closed);
+
+        return std::make_tuple(std::move(*node.ptr), channel_status::success);
+    }
+};
+
+// - Note
+//      Awaitable writer for `channel::write_for`.
+//      See `timed_reader`
+template <typename T, typename Lockable, typename Resume>
+class timed_writer final
+{
+  public:
+    using value_type = T;
+    using reference = T&;
+    using channel_type = channel<T, Lockable, Resume>;
+    using time_point = timer_wheel::time_point;
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  private:
+    using writer = writer<T, Lockable, Resume>;
+
+  private:
+    writer node;
+    channel_type* chan;
+    timer_wheel* wheel;
+    time_point until;
+    timer_node timer{};
+    internal::select_token token;
+    bool suspended = false;
+    bool expired = false;
+
+  public:
+    timed_writer(channel_type& ch, reference ref, timer_wheel& w,
+                 time_point tp) noexcept(false)
+        : node{ch, std::addressof(ref)}, chan{std::addressof(ch)},
+          wheel{std::addressof(w)}, until{tp}, token{w, timer}
+    {
+    }
+    // - Note
+    //      See `~timed_reader`
+    ~timed_writer() noexcept(false)
+    {
+        if (suspended == false)
+            return;
+        std::unique_lock lck{chan->mtx};
+        if (token.try_claim(std::addressof(node)))
+        {
+            chan->writer_list::erase(std::addressof(node));
+            wheel->cancel(timer);
+        }
+    }
+    timed_writer(const timed_writer&) = delete;
+    timed_writer(timed_writer&&) = delete;
+    timed_writer& operator=(const timed_writer&) = delete;
+    timed_writer& operator=(timed_writer&&) = delete;
+
+  public:
+    bool await_ready() noexcept(false)
+    {
+        chan->mtx.lock();
+        if (chan->pair(node) == false)
+        {
+            if (timer_wheel::clock_type::now() < until)
+                return false; // keep the lock until the suspension
+            expired = true;
+        }
+        chan->mtx.unlock();
+        return true;
+    }
+    void await_suspend(coroutine_handle<void> coro) noexcept(false)
+    {
+        channel_type& ch = *chan;
+        suspended = true;
+
+        node.frame = coro.address();
+        node.token = std::addressof(token);
+        node.next = nullptr;
+        ch.writer_list::push(std::addressof(node));
+        wheel->insert(timer, until, coro);
+        ch.mtx.unlock();
+    }
+    auto await_resume() noexcept(false) -> channel_status
+    {
+        if (suspended)
+        {
+            // the partner takes the value under the lock
+            std::unique_lock lck{chan->mtx};
+            if (token.try_claim(std::addressof(node)))
+            {
+                chan->writer_list::erase(std::addressof(node));
+                expired = true;
+            }
+        }
+        if (expired)
+            return channel_status::timeout;
+        if (node.await_resume() == false)
+            return channel_status::closed;
+        return channel_status::success;
+    }
+};
+
+// - Note
+//      Awaitable batch reader for `channel`.
+//      It completes with the first partner(s), so the result can be less
+//      than the span. 0 if the channel is closed
+template <typename T, typename Lockable, typename Resume>
+class batch_reader final
+{
+  public:
+    using value_type = T;
+    using channel_type = channel<T, Lockable, Resume>;
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  private:
+    using reader = reader<T, Lockable, Resume>;
+    using writer_list = internal::list<writer<T, Lockable, Resume>>;
+
+  private:
+    reader node;
+    channel_type* chan;
+    writer_list partners{};
+
+  public:
+    batch_reader(channel_type& ch, gsl::span<value_type> values) noexcept(
+        false)
+        : node{ch, values.data()}, chan{std::addressof(ch)}
+    {
+        node.count = static_cast<size_t>(values.size());
+    }
+
+  public:
+    bool await_ready() noexcept(false)
+    {
+        if (node.count == 0)
+            return true;
+
+        chan->mtx.lock();
+        if (chan->closed)
+            node.frame = internal::poison();
+        else if (const auto n = chan->take_n(node.ptr, node.count, partners))
+            node.count = n;
+        else
+            return false;
+
+        chan->mtx.unlock();
+        return true;
+    }
+    void await_suspend(coroutine_handle<void> coro) noexcept(false)
+    {
+        node.frame = coro.address(); // remember handle before push/unlock
+        node.next = nullptr;
+
+        chan->reader_list::push(std::addressof(node));
+        chan->mtx.unlock();
+    }
+    size_t await_resume() noexcept(false)
+    {
+        if (node.frame == internal::poison())
+            return 0;
+
+        // the values are already moved
+        chan->resume_all(partners);
+        return node.count;
+    }
+};
+
+// - Note
+//      Awaitable batch writer for `channel`.
+//      It completes with the first partner(s), so the result can be less
+//      than the span. 0 if the channel is closed
+template <typename T, typename Lockable, typename Resume>
+class batch_writer final
+{
+  public:
+    using value_type = T;
+    using channel_type = channel<T, Lockable, Resume>;
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  private:
+    using writer = writer<T, Lockable, Resume>;
+    using reader_list = internal::list<reader<T, Lockable, Resume>>;
+
+  private:
+    writer node;
+    channel_type* chan;
+    reader_list partners{};
+
+  public:
+    batch_writer(channel_type& ch, gsl::span<value_type> values) noexcept(
+        false)
+        : node{ch, values.data()}, chan{std::addressof(ch)}
+    {
+        node.count = static_cast<size_t>(values.size());
+    }
+
+  public:
+    bool await_ready() noexcept(false)
+    {
+        if (node.count == 0)
+            return true;
+
+        chan->mtx.lock();
+        if (chan->closed)
+            node.frame = internal::poison();
+        else if (const auto n = chan->give_n(node.ptr, node.count, partners))
+            node.count = n;
+        else
+            return false;
+
+        chan->mtx.unlock();
+        return true;
+    }
+    void await_suspend(coroutine_handle<void> coro) noexcept(false)
+    {
+        node.frame = coro.address(); // remember handle before push/unlock
+        node.next = nullptr;
+
+        chan->writer_list::push(std::addressof(node));
+        chan->mtx.unlock();
+    }
+    size_t await_resume() noexcept(false)
+    {
+        if (node.frame == internal::poison())
+            return 0;
+
+        // the values are already moved
+        chan->resume_all(partners);
+        return node.count;
+    }
+};
+
+// - Note
+//      Read case of `select`.
+//      The received value is moved to the reference
+template <typename T, typename Lockable, typename Resume>
+class select_read final
+{
+  public:
+    using value_type = T;
+    using reference = T&;
+    using channel_type = channel<T, Lockable, Resume>;
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  private:
+    using reader = reader<T, Lockable, Resume>;
+
+  private:
+    reader node; // the writer moves the value to the reference
+    channel_type* chan;
+
+  public:
+    select_read(channel_type& ch, reference ref) noexcept(false)
+        : node{ch, std::addressof(ref)}, chan{std::addressof(ch)}
+    {
+    }
+
+  public:
+    auto lock() noexcept -> internal::select_lock
+    {
+        return internal::select_lock::make(chan->mtx);
+    }
+    // - Note
+    //      Pair with a waiting writer. The lock must be held
+    bool try_pair() noexcept(false)
+    {
+        return chan->pair(node);
+    }
+    // - Note
+    //      Wait in the channel. The lock must be held
+    void enqueue(void* frame, internal::select_token& token) noexcept(false)
+    {
+        node.frame = frame;
+        node.token = std::addressof(token);
+        node.next = nullptr;
+        chan->reader_list::push(std::addressof(node));
+    }
+    // - Note
+    //      Leave the channel if the node is still waiting
+    void withdraw() noexcept(false)
+    {
+        std::unique_lock lck{chan->mtx};
+        chan->reader_list::erase(std::addressof(node));
+    }
+    bool owns(const void* winner) const noexcept
+    {
+        return winner == std::addressof(node);
+    }
+    // - Note
+    //      Same with `reader::await_resume`
+    bool complete() noexcept(false)
+    {
+        if (node.frame == internal::poison())
+            return false;
+
+        if (auto rh = coroutine_handle<void>::from_address(node.frame))
+        {
+            node.frame = nullptr;
+            chan->resume(rh);
+        }
+        return true;
+    }
+};
+
+// - Note
+//      Write case of `select`.
+//      The referenced value must be alive until the `select` completes
+template <typename T, typename Lockable, typename Resume>
+class select_write final
+{
+  public:
+    using value_type = T;
+    using reference = T&;
+    using channel_type = channel<T, Lockable, Resume>;
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  private:
+    using writer = writer<T, Lockable, Resume>;
+
+  private:
+    writer node;
+    channel_type* chan;
+
+  public:
+    select_write(channel_type& ch, reference ref) noexcept(false)
+        : node{ch, std::addressof(ref)}, chan{std::addressof(ch)}
+    {
+    }
+
+  public:
+    auto lock() noexcept -> internal::select_lock
+    {
+        return internal::select_lock::make(chan->mtx);
+    }
+    // - Note
+    //      Pair with a waiting reader. The lock must be held
+    bool try_pair() noexcept(false)
+    {
+        return chan->pair(node);
+    }
+    // - Note
+    //      Wait in the channel. The lock must be held
+    void enqueue(void* frame, internal::select_token& token) noexcept(false)
+    {
+        node.frame = frame;
+        node.token = std::addressof(token);
+        node.next = nullptr;
+        chan->writer_list::push(std::addressof(node));
+    }
+    // - Note
+    //      Leave the channel if the node is still waiting
+    void withdraw() noexcept(false)
+    {
+        std::unique_lock lck{chan->mtx};
+        chan->writer_list::erase(std::addressof(node));
+    }
+    bool owns(const void* winner) const noexcept
+    {
+        return winner == std::addressof(node);
+    }
+    // - Note
+    //      Same with `writer::await_resume`
+    bool complete() noexcept(false)
+    {
+        if (node.frame == internal::poison())
+            return false;
+
+        if (auto rh = coroutine_handle<void>::from_address(node.frame))
+        {
+            node.frame = nullptr;
+            chan->resume(rh);
+        }
+        return true;
+    }
+};
+
+// - Note
+//      Read case for `select`, `try_select`
+template <typename T, typename Lockable, typename Resume>
+auto on_read(channel<T, Lockable, Resume>& ch, T& ref) noexcept(false)
+    -> select_read<T, Lockable, Resume>
+{
+    return {ch, ref};
+}
+// - Note
+//      Write case for `select`, `try_select`
+template <typename T, typename Lockable, typename Resume>
+auto on_write(channel<T, Lockable, Resume>& ch, T& ref) noexcept(false)
+    -> select_write<T, Lockable, Resume>
+{
+    return {ch, ref};
+}
+
+// - Note
+//      Awaitable for `select`.
+//      Registration locks all channels in address order,
+//      so the cases are checked and enqueued at once.
+//      When a partner claims one of the waiters, the others are withdrawn
+template <typename... Cases>
+class selector final
+{
+    static_assert(sizeof...(Cases) > 0, "select requires 1 or more cases");
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+    using index_sequence = std::index_sequence_for<Cases...>;
+    using lock_array = std::array<internal::select_lock, sizeof...(Cases)>;
+
+  private:
+    std::tuple<Cases...> cases;
+    internal::select_token token{};
+    size_t index = sizeof...(Cases); // completed case
+    bool suspended = false;
+
+  public:
+    explicit selector(Cases&&... args) noexcept(false)
+        : cases{std::move(args)...}
+    {
+    }
+    selector(const selector&) noexcept(false) = delete;
+    selector& operator=(const selector&) noexcept(false) = delete;
+    selector(selector&&) noexcept(false) = delete;
+    selector& operator=(selector&&) noexcept(false) = delete;
+
+  private:
+    template <size_t... I>
+    auto make_locks(std::index_sequence<I...>) noexcept -> lock_array
+    {
+        lock_array locks{std::get<I>(cases).lock()...};
+        std::sort(locks.begin(), locks.end(),
+                  [](const internal::select_lock& lhs,
+                     const internal::select_lock& rhs) {
+                      return lhs.key < rhs.key;
+                  });
+        return locks;
+    }
+    static void lock_all(const lock_array& locks) noexcept(false)
+    {
+        for (size_t i = 0; i < locks.size(); ++i)
+            if (i == 0 || locks[i].key != locks[i - 1].key)
+                locks[i].lock(locks[i].lockable);
+    }
+    static void unlock_all(const lock_array& locks) noexcept(false)
+    {
+        for (size_t i = locks.size(); i > 0; --i)
+            if (i == 1 || locks[i - 1].key != locks[i - 2].key)
+                locks[i - 1].unlock(locks[i - 1].lockable);
+    }
+
+    // the first ready case in order
+    template <size_t... I>
+    bool try_pair(std::index_sequence<I...>) noexcept(false)
+    {
+        return ((std::get<I>(cases).try_pair() ? (index = I, true) : false) ||
+                ...);
+    }
+    template <size_t... I>
+    void enqueue(void* frame, std::index_sequence<I...>) noexcept(false)
+    {
+        (std::get<I>(cases).enqueue(frame, token), ...);
+    }
+    template <size_t... I>
+    void withdraw(std::index_sequence<I...>) noexcept(false)
+    {
+        ((I != index ? std::get<I>(cases).withdraw() : void()), ...);
+    }
+    template <size_t... I>
+    void find_winner(std::index_sequence<I...>) noexcept
+    {
+        const void* winner = token.get();
+        ((std::get<I>(cases).owns(winner) ? (index = I, void()) : void()),
+         ...);
+    }
+    template <size_t... I>
+    bool complete(std::index_sequence<I...>) noexcept(false)
+    {
+        bool ok = false;
+        ((I == index ? (ok = std::get<I>(cases).complete(), void())
+                     : void()),
+         ...);
+        return ok;
+    }
+
+  public:
+    // - Note
+    //      Poll the cases without suspension.
+    //      The index is the number of cases if none was ready
+    auto poll() noexcept(false) -> std::tuple<size_t, bool>
+    {
+        const auto locks = make_locks(index_sequence{});
+        lock_all(locks);
+        const bool paired = try_pair(index_sequence{});
+        unlock_all(locks);
+
+        if (paired == false)
+            return std::make_tuple(index, false);
+        return await_resume();
+    }
+
+  public:
+    bool await_ready() const noexcept
+    {
+        // checking and enqueueing must be done under the locks.
+        // see `await_suspend`
+        return false;
+    }
+    bool await_suspend(coroutine_handle<void> coro) noexcept(false)
+    {
+        const auto locks = make_locks(index_sequence{});
+        lock_all(locks);
+        if (try_pair(index_sequence{}))
+        {
+            unlock_all(locks);
+            return false;
+        }
+        suspended = true;
+        enqueue(coro.address(), index_sequence{});
+        // the coroutine can be resumed just after this
+        unlock_all(locks);
+        return true;
+    }
+    // - Note
+    //      Return the index of the completed case.
+    //      `false` if its channel is closed
+    auto await_resume() noexcept(false) -> std::tuple<size_t, bool>
+    {
+        if (suspended)
+        {
+            find_winner(index_sequence{});
+            withdraw(index_sequence{});
+        }
+        const bool ok = complete(index_sequence{});
+        return std::make_tuple(index, ok);
+    }
+};
+
+// - Note
+//      Wait for the first ready case among `on_read`, `on_write`.
+//      The cases are checked in order
+template <typename... Cases>
+auto select(Cases&&... cases) noexcept(false)
+    -> selector<std::decay_t<Cases>...>
+{
+    return selector<std::decay_t<Cases>...>{std::forward<Cases>(cases)...};
+}
+
+// - Note
+//      `select` with default branch. Never suspends.
+//      The index is the number of cases if none was ready
+template <typename... Cases>
+auto try_select(Cases&&... cases) noexcept(false) -> std::tuple<size_t, bool>
+{
+    selector<std::decay_t<Cases>...> s{std::forward<Cases>(cases)...};
+    return s.poll();
+}
+
+template <typename T, size_t N, typename Lockable>
+class buffered_channel;
+template <typename T, size_t N, typename Lockable>
+class buffered_reader;
+template <typename T, size_t N, typename Lockable>
+class buffered_writer;
+
+// - Note
+//      Awaitable reader for `buffered_channel`.
+//      The value is moved into the reader before the writer resumes
+template <typename T, size_t N, typename Lockable>
+class buffered_reader final
+{
+  public:
+    using value_type = T;
+    using pointer = T*;
+    using reference = T&;
+    using channel_type = buffered_channel<T, N, Lockable>;
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  private:
+    using writer = typename channel_type::writer;
+    using reader_list = typename channel_type::reader_list;
+
+    friend channel_type;
+    friend writer;
+    friend reader_list;
+
+  private:
+    mutable value_type value; // Received value
+    mutable void* frame;      // Writer to resume after read
+    union {
+        buffered_reader* next = nullptr; // Next reader in channel
+        channel_type* chan;              // Channel to push this reader
+    };
+
+  private:
+    explicit buffered_reader(channel_type& ch) noexcept(false)
+        : value{}, frame{nullptr}, chan{std::addressof(ch)}
+    {
+    }
+    buffered_reader(const buffered_reader&) noexcept(false) = delete;
+    buffered_reader& operator=(const buffered_reader&) noexcept(false) = delete;
+
+  public:
+    buffered_reader(buffered_reader&& rhs) noexcept(false)
+        : value{}, frame{nullptr}, chan{nullptr}
+    {
+        std::swap(this->value, rhs.value);
+        std::swap(this->frame, rhs.frame);
+        std::swap(this->chan, rhs.chan);
+    }
+    buffered_reader& operator=(buffered_reader&& rhs) noexcept(false)
+    {
+        std::swap(this->value, rhs.value);
+        std::swap(this->frame, rhs.frame);
+        std::swap(this->chan, rhs.chan);
+        return *this;
+    }
+
+  public:
+    bool await_ready() const noexcept(false);
+    void await_suspend(coroutine_handle<void> rh) noexcept(false);
+    auto await_resume() noexcept(false) -> std::tuple<value_type, bool>;
+};
+
+// - Note
+//      Awaitable writer for `buffered_channel`.
+//      It suspends only when the buffer is full
+template <typename T, size_t N, typename Lockable>
+class buffered_writer final
+{
+  public:
+    using value_type = T;
+    using pointer = T*;
+    using reference = T&;
+    using channel_type = buffered_channel<T, N, Lockable>;
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  private:
+    using reader = typename channel_type::reader;
+    using writer_list = typename channel_type::writer_list;
+
+    friend channel_type;
+    friend reader;
+    friend writer_list;
+
+  private:
+    mutable pointer ptr; // Address of value
+    mutable void* frame; // Reader to resume after write
+    union {
+        buffered_writer* next = nullptr; // Next writer in channel
+        channel_type* chan;              // Channel to push this writer
+    };
+
+  private:
+    explicit buffered_writer(channel_type& ch, pointer pv) noexcept(false)
+        : ptr{pv}, frame{nullptr}, chan{std::addressof(ch)}
+    {
+    }
+    buffered_writer(const buffered_writer&) noexcept(false) = delete;
+    buffered_writer& operator=(const buffered_writer&) noexcept(false) = delete;
+
+  public:
+    // - Note
+    //      See `reader(reader&&)`
+    buffered_writer(buffered_writer&& rhs) noexcept(false)
+        : ptr{nullptr}, frame{nullptr}, chan{nullptr}
+    {
+        std::swap(this->ptr, rhs.ptr);
+        std::swap(this->frame, rhs.frame);
+        std::swap(this->chan, rhs.chan);
+    }
+    buffered_writer& operator=(buffered_writer&& rhs) noexcept(false)
+    {
+        std::swap(this->ptr, rhs.ptr);
+        std::swap(this->frame, rhs.frame);
+        std::swap(this->chan, rhs.chan);
+        return *this;
+    }
+
+  public:
+    bool await_ready() const noexcept(false);
+    void await_suspend(coroutine_handle<void> rh) noexcept(false);
+    bool await_resume() noexcept(false);
+};
+
+// - Note
+//      Coroutine Channel with fixed size buffer.
+//      Similar to `make(chan T, N)` in The Go Language.
+//      Writers don't suspend while the buffer has room,
+//      and readers don't suspend while the buffer has values.
+//      Channel doesn't support Copy, Move
+template <typename T, size_t N, typename Lockable>
+class buffered_channel final : internal::list<buffered_reader<T, N, Lockable>>,
+                               internal::list<buffered_writer<T, N, Lockable>>
+{
+    static_assert(std::is_reference<T>::value == false,
+                  "Using reference for channel is forbidden.");
+    static_assert(N > 0, "Use `channel` for unbuffered channel");
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  public:
+    using value_type = T;
+    using pointer = value_type*;
+    using reference = value_type&;
+
+    using mutex_t = Lockable;
+
+    static constexpr size_t capacity = N;
+
+  private:
+    using reader = buffered_reader<value_type, N, mutex_t>;
+    using reader_list = internal::list<reader>;
+
+    using writer = buffered_writer<value_type, N, mutex_t>;
+    using writer_list = internal::list<writer>;
+
+    friend reader;
+    friend writer;
+
+  private:
+    mutex_t mtx{};
+    internal::ring<value_type, N> buffer{};
+    bool closed = false;
+
+  public:
+    buffered_channel() noexcept(false) : reader_list{}, writer_list{}, mtx{}
+    {
+    }
+    buffered_channel(const buffered_channel&) noexcept(false) = delete;
+    buffered_channel(buffered_channel&&) noexcept(false) = delete;
+
+    buffered_channel& operator=(const buffered_channel&) noexcept(false) =
+        delete;
+    buffered_channel& operator=(buffered_channel&&) noexcept(false) = delete;
+
+    ~buffered_channel() noexcept(false)
+    {
+        // see the destructor of `channel`
+        close();
+    }
+
+  public:
+    // - Note
+    //      Close the channel. Same with `channel::close`,
+    //      but readers can take the values in the buffer before `false`
+    void close() noexcept(false)
+    {
+        reader_list readers{};
+        writer_list writers{};
+        {
+            std::unique_lock lck{this->mtx};
+            if (closed)
+                return;
+            closed = true;
+
+            // detach the waiters
+            std::swap(readers, static_cast<reader_list&>(*this));
+            std::swap(writers, static_cast<writer_list&>(*this));
+        }
+        cancel(writers);
+        cancel(readers);
+    }
+
+  private:
+    // - Note
+    //      Resume the detached waiters with poison
+    template <typename Node>
+    static void cancel(internal::list<Node>& nodes) noexcept(false)
+    {
+        while (Node* node = nodes.pop())
+        {
+            auto rh = coroutine_handle<void>::from_address(node->frame);
+            node->frame = internal::poison();
+
+            rh.resume();
+        }
+    }
+
+  public:
+    // - Note
+    //      Awaitable write.
+    //      `buffered_writer` type implements the awaitable concept
+    decltype(auto) write(reference ref) noexcept(false)
+    {
+        return writer{*this, std::addressof(ref)};
+    }
+    // - Note
+    //      Awaitable read.
+    //      `buffered_reader` type implements the awaitable concept
+    decltype(auto) read() noexcept(false)
+    {
+        return reader{*this};
+    }
+};
+
+template <typename T, size_t N, typename M>
+bool buffered_reader<T, N, M>::await_ready() const noexcept(false)
+{
+    chan->mtx.lock();
+    // writers wait only when the buffer is full.
+    // so if it is empty, there is no writer
+    if (chan->buffer.is_empty())
+    {
+        if (chan->closed == false)
+            return false;
+
+        this->frame = internal::poison();
+        chan->mtx.unlock();
+        return true;
+    }
+
+    chan->buffer.pop(this->value);
+    if (chan->writer_list::is_empty() == false)
+    {
+        // there is a room now. take the value of waiting writer
+        writer* w = chan->writer_list::pop();
+        chan->buffer.push(std::move(*w->ptr));
+        std::swap(this->frame, w->frame);
+    }
+
+    chan->mtx.unlock();
+    return true;
+}
+
+template <typename T, size_t N, typename M>
+void buffered_reader<T, N, M>::await_suspend(
+    coroutine_handle<void> coro) noexcept(false)
+{
+    // notice that next & chan are sharing memory
+    channel_type& ch = *(this->chan);
+
+    this->frame = coro.address(); // remember handle before push/unlock
+    this->next = nullptr;         // clear to prevent confusing
+
+    ch.reader_list::push(this); // push to channel
+    ch.mtx.unlock();
+}
+
+template <typename T, size_t N, typename M>
+auto buffered_reader<T, N, M>::await_resume() noexcept(false)
+    -> std::tuple<value_type, bool>
+{
+    // frame holds poision if the channel is closed
+    if (this->frame == internal::poison())
+        return std::make_tuple(value_type{}, false);
+
+    value_type v = std::move(this->value);
+    // resume the writer which was waiting for the room
+    if (auto rh = coroutine_handle<void>::from_address(frame))
+    {
+        this->frame = nullptr;
+        rh.resume();
+    }
+    return std::make_tuple(std::move(v), true);
+}
+
+template <typename T, size_t N, typename M>
+bool buffered_writer<T, N, M>::await_ready() const noexcept(false)
+{
+    chan->mtx.lock();
+    if (chan->closed)
+    {
+        this->frame = internal::poison();
+        chan->mtx.unlock();
+        return true;
+    }
+    // readers wait only when the buffer is empty.
+    // hand off the value directly
+    if (chan->reader_list::is_empty() == false)
+    {
+        reader* r = chan->reader_list::pop();
+        r->value = std::move(*ptr);
+        std::swap(this->frame, r->frame);
+
+        chan->mtx.unlock();
+        return true;
+    }
+    if (chan->buffer.is_full())
+        return false;
+
+    chan->buffer.push(std::move(*ptr));
+    chan->mtx.unlock();
+    return true;
+}
+
+template <typename T, size_t N, typename M>
+void buffered_writer<T, N, M>::await_suspend(
+    coroutine_handle<void> coro) noexcept(false)
+{
+    // notice that next & chan are sharing memory
+    channel_type& ch = *(this->chan);
+
+    this->frame = coro.address(); // remember handle before push/unlock
+    this->next = nullptr;         // clear to prevent confusing
+
+    ch.writer_list::push(this); // push to channel
+    ch.mtx.unlock();
+}
+
+template <typename T, size_t N, typename M>
+bool buffered_writer<T, N, M>::await_resume() noexcept(false)
+{
+    // frame holds poision if the channel is closed
+    if (this->frame == internal::poison())
+        return false;
+
+    // resume the reader which received the value
+    if (auto rh = coroutine_handle<void>::from_address(frame))
+    {
+        this->frame = nullptr;
+        rh.resume();
+    }
+    return true;
+}
+
+namespace internal
+{
+// - Note
+//      Pointer, 1 bit tag, and 16 bit counter in a 64 bit word.
+//      The tag uses the lowest bit of the aligned pointer.
+//      The counter is increased for each change to prevent ABA problem.
+//      Assume 48 bit virtual address space. See `fits`
+struct tagged_word
+{
+    static constexpr uint64_t address_mask = (uint64_t{1} << 48) - 2;
+    static constexpr uint64_t tag_mask = 1;
+    static constexpr uint32_t counter_shift = 48;
+
+    static_assert(sizeof(void*) == sizeof(uint64_t),
+                  "Tagged pointer requires 64 bit address");
+
+    static uint64_t make(void* ptr, uint64_t tag, uint64_t old) noexcept
+    {
+        const auto counter = (old >> counter_shift) + 1;
+        return (counter << counter_shift) |
+               (reinterpret_cast<uint64_t>(ptr) & address_mask) | tag;
+    }
+    static void* address_of(uint64_t word) noexcept
+    {
+        return reinterpret_cast<void*>(word & address_mask);
+    }
+    static uint64_t tag_of(uint64_t word) noexcept
+    {
+        return word & tag_mask;
+    }
+    // - Note
+    //      `false` if the pointer loses its bits in the word.
+    //      For example, 57 bit address (LA57) or the top byte tag (TBI, MTE)
+    static bool fits(const void* ptr) noexcept
+    {
+        return (reinterpret_cast<uint64_t>(ptr) & ~address_mask) == 0;
+    }
+};
+} // namespace internal
+
+template <typename T>
+class lock_free_channel;
+template <typename T>
+class lock_free_reader;
+template <typename T>
+class lock_free_writer;
+
+// - Note
+//      Awaitable reader for `lock_free_channel`
+template <typename T>
+class lock_free_reader final
+{
+  public:
+    using value_type = T;
+    using pointer = T*;
+    using reference = T&;
+    using channel_type = lock_free_channel<T>;
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  private:
+    using writer = typename channel_type::writer;
+
+    friend channel_type;
+    friend writer;
+
+  private:
+    value_type value;                        // Received value
+    void* frame;                             // Resumeable Handle
+    std::atomic<lock_free_reader*> next;     // Next reader in channel
+    channel_type* chan;                      // Channel to push this reader
+
+  private:
+    explicit lock_free_reader(channel_type& ch) noexcept(false)
+        : value{}, frame{nullptr}, next{nullptr}, chan{std::addressof(ch)}
+    {
+    }
+    lock_free_reader(const lock_free_reader&) noexcept(false) = delete;
+    lock_free_reader& operator=(const lock_free_reader&) noexcept(false) =
+        delete;
+
+  public:
+    // - Note
+    //      Move is allowed only before `co_await`
+    lock_free_reader(lock_free_reader&& rhs) noexcept(false)
+        : value{std::move(rhs.value)}, frame{rhs.frame}, next{nullptr},
+          chan{rhs.chan}
+    {
+    }
+
+  public:
+    bool await_ready() const noexcept
+    {
+        // pairing and suspension must be decided by one CAS.
+        // see `await_suspend`
+        return false;
+    }
+    bool await_suspend(coroutine_handle<void> rh) noexcept(false);
+    auto await_resume() noexcept(false) -> std::tuple<value_type, bool>;
+};
+
+// - Note
+//      Awaitable writer for `lock_free_channel`
+template <typename T>
+class lock_free_writer final
+{
+  public:
+    using value_type = T;
+    using pointer = T*;
+    using reference = T&;
+    using channel_type = lock_free_channel<T>;
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  private:
+    using reader = typename channel_type::reader;
+
+    friend channel_type;
+    friend reader;
+
+  private:
+    pointer ptr;                         // Address of value
+    void* frame;                         // Resumeable Handle
+    std::atomic<lock_free_writer*> next; // Next writer in channel
+    channel_type* chan;                  // Channel to push this writer
+
+  private:
+    explicit lock_free_writer(channel_type& ch, pointer pv) noexcept(false)
+        : ptr{pv}, frame{nullptr}, next{nullptr}, chan{std::addressof(ch)}
+    {
+    }
+    lock_free_writer(const lock_free_writer&) noexcept(false) = delete;
+    lock_free_writer& operator=(const lock_free_writer&) noexcept(false) =
+        delete;
+
+  public:
+    // - Note
+    //      Move is allowed only before `co_await`
+    lock_free_writer(lock_free_writer&& rhs) noexcept(false)
+        : ptr{rhs.ptr}, frame{rhs.frame}, next{nullptr}, chan{rhs.chan}
+    {
+    }
+
+  public:
+    bool await_ready() const noexcept
+    {
+        // see `lock_free_reader::await_ready`
+        return false;
+    }
+    bool await_suspend(coroutine_handle<void> rh) noexcept(false);
+    bool await_resume() noexcept(false);
+};
+
+// - Note
+//      Unbuffered coroutine channel without lock.
+//      Waiting readers or writers are in one Treiber stack.
+//      The stack holds only one kind at a time, so an operation either
+//      pops its partner or pushes itself with a single CAS.
+//
+//      The order of waiters is LIFO, unlike `channel`. The latest waiter
+//      is paired first, and the early ones can wait long under load.
+//      Since a pop takes the whole stack and gives back the rest,
+//      the waiters pushed meanwhile can go below the rest.
+//      Use `channel` if the order matters.
+//
+//      Channel doesn't support Copy, Move
+template <typename T>
+class lock_free_channel final
+{
+    static_assert(std::is_reference<T>::value == false,
+                  "Using reference for channel is forbidden.");
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  public:
+    using value_type = T;
+    using pointer = value_type*;
+    using reference = value_type&;
+
+  private:
+    using reader = lock_free_reader<value_type>;
+    using writer = lock_free_writer<value_type>;
+
+    friend reader;
+    friend writer;
+
+    // tag of the waiters in the stack
+    static constexpr uint64_t reader_tag = 0;
+    static constexpr uint64_t writer_tag = 1;
+
+    static_assert(alignof(reader) > internal::tagged_word::tag_mask &&
+                      alignof(writer) > internal::tagged_word::tag_mask,
+                  "The lowest bit of the waiter is used for the tag");
+
+  private:
+    std::atomic<uint64_t> top{};
+
+  public:
+    lock_free_channel() noexcept = default;
+    lock_free_channel(const lock_free_channel&) noexcept(false) = delete;
+    lock_free_channel(lock_free_channel&&) noexcept(false) = delete;
+
+    lock_free_channel& operator=(const lock_free_channel&) noexcept(false) =
+        delete;
+    lock_free_channel& operator=(lock_free_channel&&) noexcept(false) = delete;
+
+    ~lock_free_channel() noexcept(false)
+    {
+        // detach all waiters at once, then cancel them
+        const auto word = top.exchange(0, std::memory_order_acquire);
+        void* node = internal::tagged_word::address_of(word);
+        if (internal::tagged_word::tag_of(word) == writer_tag)
+            cancel_all(static_cast<writer*>(node));
+        else
+            cancel_all(static_cast<reader*>(node));
+    }
+
+  private:
+    template <typename Node>
+    static void cancel_all(Node* node) noexcept(false)
+    {
+        while (node)
+        {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            auto rh = coroutine_handle<void>::from_address(node->frame);
+            node->frame = internal::poison();
+
+            rh.resume();
+            node = next;
+        }
+    }
+
+    // - Note
+    //      Complete the 2 waiters in the stack.
+    //      Same with `lock_free_reader::await_suspend`,
+    //      but the reader is suspended too. It resumes the writer
+    static void exchange(reader* r, writer* w) noexcept(false)
+    {
+        r->value = std::move(*w->ptr);
+        auto rh = coroutine_handle<void>::from_address(r->frame);
+        r->frame = w->frame;
+        w->frame = nullptr;
+        rh.resume();
+    }
+    static void exchange(writer* w, reader* r) noexcept(false)
+    {
+        exchange(r, w);
+    }
+
+    // - Note
+    //      Pop a waiter with the tag, or push the node if there is none.
+    //      Return the popped partner. `nullptr` if the node is pushed
+    //
+    //      The partner can be resumed by others and its frame can be
+    //      destroyed at any time before it is popped, so the popper must
+    //      not read it until then. It takes the whole stack with one CAS,
+    //      and gives back the rest after it owns them
+    template <typename Partner, typename Node>
+    auto pop_or_push(uint64_t partner_tag, Node* node) noexcept(false)
+        -> Partner*
+    {
+        using internal::tagged_word;
+
+        auto word = top.load(std::memory_order_acquire);
+        while (true)
+        {
+            void* head = tagged_word::address_of(word);
+            if (head && tagged_word::tag_of(word) == partner_tag)
+            {
+                // detach all. no one else can pop them after this
+                const auto empty = tagged_word::make(nullptr, reader_tag, word);
+                if (top.compare_exchange_weak(word, empty,
+                                              std::memory_order_acquire,
+                                              std::memory_order_acquire) ==
+                    false)
+                    continue;
+
+                auto* partner = static_cast<Partner*>(head);
+                if (auto* rest = partner->next.load(std::memory_order_relaxed))
+                    give_back(partner_tag, rest);
+                return partner;
+            }
+            // empty or same kind of waiters. push
+            if (tagged_word::fits(node) == false)
+                throw std::system_error{
+                    std::make_error_code(std::errc::bad_address),
+                    "lock_free_channel: the waiter's address doesn't fit"};
+
+            node->next.store(static_cast<Node*>(head),
+                             std::memory_order_relaxed);
+            const auto desired =
+                tagged_word::make(node, partner_tag ^ 1, word);
+            if (top.compare_exchange_weak(word, desired,
+                                          std::memory_order_release,
+                                          std::memory_order_acquire))
+                return nullptr;
+        }
+    }
+
+    // - Note
+    //      Push the waiters taken by `pop_or_push` again.
+    //      If the other kind are pushed meanwhile, they are waiting for
+    //      the ones in the list. Take them and complete the pairs here
+    template <typename Node>
+    void give_back(uint64_t tag, Node* list) noexcept(false)
+    {
+        using internal::tagged_word;
+        using other_type =
+            std::conditional_t<std::is_same_v<Node, reader>, writer, reader>;
+
+        auto word = top.load(std::memory_order_acquire);
+        while (list)
+        {
+            void* head = tagged_word::address_of(word);
+            if (head == nullptr || tagged_word::tag_of(word) == tag)
+            {
+                Node* tail = list;
+                while (Node* next = tail->next.load(std::memory_order_relaxed))
+                    tail = next;
+                tail->next.store(static_cast<Node*>(head),
+                                 std::memory_order_relaxed);
+                const auto desired = tagged_word::make(list, tag, word);
+                if (top.compare_exchange_weak(word, desired,
+                                              std::memory_order_release,
+                                              std::memory_order_acquire))
+                    return;
+                // the stack is changed. restore the end of the list
+                tail->next.store(nullptr, std::memory_order_relaxed);
+                continue;
+            }
+
+            const auto desired = tagged_word::make(nullptr, reader_tag, word);
+            if (top.compare_exchange_weak(word, desired,
+                                          std::memory_order_acquire,
+                                          std::memory_order_acquire) == false)
+                continue;
+
+            // read the links before the resumption
+            auto* other = static_cast<other_type*>(head);
+            while (list && other)
+            {
+                Node* n = list;
+                other_type* o = other;
+                list = n->next.load(std::memory_order_relaxed);
+                other = o->next.load(std::memory_order_relaxed);
+                exchange(n, o);
+            }
+            if (other)
+                give_back(tag ^ 1, other);
+            word = top.load(std::memory_order_acquire);
+        }
+    }
+
+  public:
+    // - Note
+    //      Awaitable write.
+    //      `lock_free_writer` type implements the awaitable concept
+    decltype(auto) write(reference ref) noexcept(false)
+    {
+        return writer{*this, std::addressof(ref)};
+    }
+    // - Note
+    //      Awaitable read.
+    //      `lock_free_reader` type implements the awaitable concept
+    decltype(auto) read() noexcept(false)
+    {
+        return reader{*this};
+    }
+};
+
+template <typename T>
+bool lock_free_reader<T>::await_suspend(
+    coroutine_handle<void> coro) noexcept(false)
+{
+    // remember handle before push
+    this->frame = coro.address();
+
+    writer* w = chan->template pop_or_push<writer>(channel_type::writer_tag,
+                                                   this);
+    if (w == nullptr)
+        return true; // pushed. the writer will resume this coroutine
+
+    // take the value and the writer's handle to resume
+    this->value = std::move(*w->ptr);
+    this->frame = w->frame;
+    w->frame = nullptr;
+    return false;
+}
+
+template <typename T>
+auto lock_free_reader<T>::await_resume() noexcept(false)
+    -> std::tuple<value_type, bool>
+{
+    // frame holds poision if the channel is going to destroy
+    if (this->frame == internal::poison())
+        return std::make_tuple(value_type{}, false);
+
+    value_type v = std::move(this->value);
+    if (auto rh = coroutine_handle<void>::from_address(frame))
+    {
+        this->frame = nullptr;
+        rh.resume();
+    }
+    return std::make_tuple(std::move(v), true);
+}
+
+template <typename T>
+bool lock_free_writer<T>::await_suspend(
+    coroutine_handle<void> coro) noexcept(false)
+{
+    // remember handle before push
+    this->frame = coro.address();
+
+    reader* r = chan->template pop_or_push<reader>(channel_type::reader_tag,
+                                                   this);
+    if (r == nullptr)
+        return true; // pushed. the reader will resume this coroutine
+
+    // give the value and take the reader's handle to resume
+    r->value = std::move(*ptr);
+    this->frame = r->frame;
+    r->frame = nullptr;
+    return false;
+}
+
+template <typename T>
+bool lock_free_writer<T>::await_resume() noexcept(false)
+{
+    // frame holds poision if the channel is going to destroy
+    if (this->frame == internal::poison())
+        return false;
+
+    if (auto rh = coroutine_handle<void>::from_address(frame))
+    {
+        this->frame = nullptr;
+        rh.resume();
+    }
+    return true;
+}
+
+// - Note
+//      Policy of `broadcast_channel` when a slow subscriber makes it full
+enum class broadcast_policy : uint32_t
+{
+    block = 0,       // writer waits until the oldest message is released
+    drop_oldest = 1, // subscribers which didn't read the oldest one skip it
+};
+
+template <typename T, size_t N, typename Lockable>
+class broadcast_channel;
+template <typename T, size_t N, typename Lockable>
+class subscriber;
+template <typename T, size_t N, typename Lockable>
+class broadcast_reader;
+template <typename T, size_t N, typename Lockable>
+class broadcast_writer;
+
+// - Note
+//      Reader of `broadcast_channel`.
+//      It receives the messages written after the subscription.
+//      Only 1 `read` can be awaited at once
+template <typename T, size_t N, typename Lockable>
+class subscriber final
+{
+  public:
+    using value_type = T;
+    using channel_type = broadcast_channel<T, N, Lockable>;
+
+  private:
+    friend channel_type;
+    friend broadcast_reader<T, N, Lockable>;
+    friend internal::list<subscriber>;
+
+  private:
+    channel_type* chan;
+    uint64_t cursor = 0;       // sequence to read next
+    uint64_t held = 0;         // sequence of `msg`
+    const value_type* msg{};   // message in use. `nullptr` if none
+    void* frame = nullptr;     // coroutine to resume
+    bool waiting = false;      // suspended in `read`. guarded by the lock
+    subscriber* next{};        // next subscriber to resume
+    uint64_t drop_count = 0;   // num of skipped messages
+
+  public:
+    explicit subscriber(channel_type& ch) noexcept(false)
+        : chan{std::addressof(ch)}
+    {
+        ch.subscribe(*this);
+    }
+    ~subscriber() noexcept(false)
+    {
+        chan->unsubscribe(*this);
+    }
+    subscriber(const subscriber&) = delete;
+    subscriber(subscriber&&) = delete;
+    subscriber& operator=(const subscriber&) = delete;
+    subscriber& operator=(subscriber&&) = delete;
+
+  public:
+    // - Note
+    //      Awaitable read. `co_await` returns the address of the message,
+    //      which is valid until the next `read` or `release`.
+    //      `nullptr` if the channel is closed and there is no more message
+    decltype(auto) read() noexcept(false)
+    {
+        return broadcast_reader<T, N, Lockable>{*this};
+    }
+    // - Note
+    //      Release the message before the next `read`
+    void release() noexcept(false)
+    {
+        chan->release(*this);
+    }
+    // - Note
+    //      Num of messages skipped by `broadcast_policy::drop_oldest`
+    uint64_t dropped() const noexcept
+    {
+        return drop_count;
+    }
+};
+
+// - Note
+//      Awaitable for `subscriber::read`.
+//      It releases the previous message first
+template <typename T, size_t N, typename Lockable>
+class broadcast_reader final
+{
+  public:
+    using value_type = T;
+    using channel_type = broadcast_channel<T, N, Lockable>;
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  private:
+    using subscriber_list = internal::list<subscriber<T, N, Lockable>>;
+    using writer_list = internal::list<broadcast_writer<T, N, Lockable>>;
+
+  private:
+    subscriber<T, N, Lockable>* sub;
+    subscriber_list readers{}; // woken by the writers below
+    writer_list writers{};     // waited for the released slot
+
+  public:
+    explicit broadcast_reader(subscriber<T, N, Lockable>& s) noexcept
+        : sub{std::addressof(s)}
+    {
+    }
+
+  public:
+    bool await_ready() noexcept(false)
+    {
+        channel_type& ch = *sub->chan;
+        ch.mtx.lock();
+        ch.release_locked(*sub);
+        ch.drain(readers, writers);
+        if (ch.take(*sub) == false && ch.closed == false)
+            return false; // keep the lock until the suspension
+
+        ch.mtx.unlock();
+        return true;
+    }
+    void await_suspend(coroutine_handle<void> coro) noexcept(false)
+    {
+        channel_type& ch = *sub->chan;
+        sub->frame = coro.address(); // remember handle before unlock
+        sub->waiting = true;
+        ch.mtx.unlock();
+    }
+    auto await_resume() noexcept(false) -> const value_type*
+    {
+        channel_type::resume_all(writers);
+        channel_type::resume_all(readers);
+        return sub->msg;
+    }
+};
+
+// - Note
+//      Awaitable writer for `broadcast_channel`.
+//      `co_await` returns `false` if the channel is closed
+template <typename T, size_t N, typename Lockable>
+class broadcast_writer final
+{
+  public:
+    using value_type = T;
+    using pointer = T*;
+    using channel_type = broadcast_channel<T, N, Lockable>;
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  private:
+    using subscriber_list = internal::list<subscriber<T, N, Lockable>>;
+
+    friend channel_type;
+    friend internal::list<broadcast_writer>;
+
+  private:
+    pointer ptr;
+    void* frame = nullptr;
+    union {
+        broadcast_writer* next = nullptr; // Next writer in channel
+        channel_type* chan;               // Channel to push this writer
+    };
+    subscriber_list readers{}; // woken by this write
+
+  public:
+    broadcast_writer(channel_type& ch, pointer pv) noexcept
+        : ptr{pv}, chan{std::addressof(ch)}
+    {
+    }
+
+  public:
+    bool await_ready() noexcept(false)
+    {
+        channel_type& ch = *chan;
+        ch.mtx.lock();
+        if (ch.closed)
+            frame = internal::poison();
+        else if (ch.publish(std::move(*ptr), readers) == false)
+            return false; // keep the lock until the suspension
+
+        ch.mtx.unlock();
+        return true;
+    }
+    void await_suspend(coroutine_handle<void> coro) noexcept(false)
+    {
+        // notice that next & chan are sharing memory
+        channel_type& ch = *chan;
+
+        this->frame = coro.address(); // remember handle before push/unlock
+        this->next = nullptr;
+
+        ch.writers.push(this);
+        ch.mtx.unlock();
+    }
+    bool await_resume() noexcept(false)
+    {
+        // frame holds poision if the channel is closed
+        if (frame == internal::poison())
+            return false;
+
+        channel_type::resume_all(readers);
+        return true;
+    }
+};
+
+// - Note
+//      Fan-out channel with fixed size ring.
+//      Each message is delivered by reference to all subscribers,
+//      and its slot is released when all of them are done with it.
+//      Channel doesn't support Copy, Move
+template <typename T, size_t N, typename Lockable>
+class broadcast_channel final
+{
+    static_assert(std::is_reference<T>::value == false,
+                  "Using reference for channel is forbidden.");
+    static_assert(N > 0, "Broadcast requires 1 or more slots");
+
+    template <typename P>
+    using coroutine_handle = typename std::experimental::coroutine_handle<P>;
+
+  public:
+    using value_type = T;
+    using pointer = value_type*;
+    using reference = value_type&;
+
+    using mutex_t = Lockable;
+
+    static constexpr size_t capacity = N;
+
+  private:
+    using subscriber_type = subscriber<T, N, Lockable>;
+    using subscriber_list = internal::list<subscriber_type>;
+    using writer = broadcast_writer<T, N, Lockable>;
+    using writer_list = internal::list<writer>;
+
+    friend subscriber_type;
+    friend writer;
+    friend broadcast_reader<T, N, Lockable>;
+
+    struct slot_t
+    {
+        value_type value{};
+        size_t refs = 0; // subscribers which didn't release it
+    };
+
+  private:
+    mutex_t mtx{};
+    bool closed = false;
+    broadcast_policy policy;
+    uint64_t head = 0; // sequence of the next message
+    uint64_t tail = 0; // sequence of the oldest message in use
+    std::array<slot_t, N> slots{};
+    std::vector<subscriber_type*> subscribers{};
+    writer_list writers{}; // waiting for a free slot
+
+  public:
+    explicit broadcast_channel(
+        broadcast_policy p = broadcast_policy::block) noexcept(false)
+        : policy{p}
+    {
+    }
+    broadcast_channel(const broadcast_channel&) = delete;
+    broadcast_channel(broadcast_channel&&) = delete;
+    broadcast_channel& operator=(const broadcast_channel&) = delete;
+    broadcast_channel& operator=(broadcast_channel&&) = delete;
+
+    // - Note
+    //      All subscribers must be destroyed before the channel
+    ~broadcast_channel() noexcept(false)
+    {
+        close();
+    }
+
+  public:
+    // - Note
+    //      Awaitable write.
+    //      The value is moved into the ring
+    decltype(auto) write(reference ref) noexcept(false)
+    {
+        return writer{*this, std::addressof(ref)};
+    }
+    // - Note
+    //      Close the channel. Waiting writers complete with `false`.
+    //      Subscribers can read the remaining messages, then `nullptr`
+    void close() noexcept(false)
+    {
+        subscriber_list readers{};
+        writer_list cancelled{};
+        {
+            std::unique_lock lck{mtx};
+            if (closed)
+                return;
+            closed = true;
+
+            std::swap(cancelled, writers);
+            for (subscriber_type* s : subscribers)
+                if (s->waiting)
+                {
+                    s->waiting = false;
+                    readers.push(s);
+                }
+        }
+        while (writer* w = cancelled.pop())
+        {
+            auto rh = coroutine_handle<void>::from_address(w->frame);
+            w->frame = internal::poison();
+            rh.resume();
+        }
+        resume_all(readers);
+    }
+
+  private:
+    template <typename Node>
+    static void resume_all(internal::list<Node>& nodes) noexcept(false)
+    {
+        while (Node* node = nodes.pop())
+        {
+            auto rh = coroutine_handle<void>::from_address(node->frame);
+            node->frame = nullptr;
+            rh.resume();
+        }
+    }
+
+    void subscribe(subscriber_type& s) noexcept(false)
+    {
+        std::unique_lock lck{mtx};
+        s.cursor = head; // only the messages after this
+        subscribers.push_back(std::addressof(s));
+    }
+    void unsubscribe(subscriber_type& s) noexcept(false)
+    {
+        subscriber_list readers{};
+        writer_list released{};
+        {
+            std::unique_lock lck{mtx};
+            assert(s.waiting == false);
+            subscribers.erase(std::find(subscribers.begin(),
+                                        subscribers.end(), std::addressof(s)));
+            release_locked(s);
+            // the messages it didn't read
+            for (; s.cursor < head; ++s.cursor)
+                slots[s.cursor % N].refs -= 1;
+            reclaim();
+            drain(readers, released);
+        }
+        resume_all(released);
+        resume_all(readers);
+    }
+
+    void release(subscriber_type& s) noexcept(false)
+    {
+        subscriber_list readers{};
+        writer_list released{};
+        {
+            std::unique_lock lck{mtx};
+            release_locked(s);
+            drain(readers, released);
+        }
+        resume_all(released);
+        resume_all(readers);
+    }
+
+    // - Note
+    //      Release the message in use. The lock must be held
+    void release_locked(subscriber_type& s) noexcept
+    {
+        if (s.msg == nullptr)
+            return;
+        s.msg = nullptr;
+        slots[s.held % N].refs -= 1;
+        reclaim();
+    }
+    // - Note
+    //      Advance the tail over the slots nobody uses.
+    //      The values are reset so large payloads are freed early
+    void reclaim() noexcept(false)
+    {
+        for (; tail < head && slots[tail % N].refs == 0; ++tail)
+            slots[tail % N].value = value_type{};
+    }
+    // - Note
+    //      Skip the oldest message for the subscribers which
+    //      didn't read it. It can't be dropped if someone is using it
+    void drop_oldest() noexcept(false)
+    {
+        slot_t& slot = slots[tail % N];
+        for (subscriber_type* s : subscribers)
+            if (s->cursor == tail)
+            {
+                s->cursor += 1;
+                s->drop_count += 1;
+                slot.refs -= 1;
+            }
+        reclaim();
+    }
+
+    // - Note
+    //      Take the next message. The lock must be held
+    bool take(subscriber_type& s) noexcept
+    {
+        if (s.cursor == head)
+            return false;
+
+        s.held = s.cursor++;
+        s.msg = std::addressof(slots[s.held % N].value);
+        return true;
+    }
+    // - Note
+    //      Put the value in the ring and give it to the waiting subscribers.
+    //      They are moved to `readers` to resume after unlock.
+    //      Return `false` if there is no room. The lock must be held
+    bool publish(value_type&& value, subscriber_list& readers) noexcept(false)
+    {
+        if (head - tail == N && policy == broadcast_policy::drop_oldest)
+            drop_oldest();
+        if (head - tail == N)
+            return false;
+
+        slot_t& slot = slots[head % N];
+        slot.value = std::move(value);
+        slot.refs = subscribers.size();
+        head += 1;
+
+        for (subscriber_type* s : subscribers)
+            if (s->waiting && take(*s))
+            {
+                s->waiting = false;
+                readers.push(s);
+            }
+        reclaim(); // nobody subscribes
+        return true;
+    }
+    // - Note
+    //      Publish the values of the waiting writers while there is room.
+    //      The lock must be held
+    void drain(subscriber_list& readers, writer_list& released) noexcept(false)
+    {
+        while (writers.is_empty() == false && head - tail < N)
+        {
+            writer* w = writers.pop();
+            publish(std::move(*w->ptr), readers);
+            released.push(w);
+        }
+    }
+};
+
 #endif // COROUTINE_CHANNEL_HPP
@@ -0,0 +1,354 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+//  Note
+//      Pipeline of coroutines connected with `buffered_channel`.
+//      Adjacent `map`, `filter` stages are fused into the next stage
+//      which owns a frame, so they don't add a channel and a lock
+//
+// ---------------------------------------------------------------------------
+#ifndef COROUTINE_PIPELINE_HPP
+#define COROUTINE_PIPELINE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <coroutine/channel.hpp>
+#include <coroutine/return.h>
+#include <gsl/gsl>
+
+// - Note
+//      Counters of a pipeline stage.
+//      `input_count / time` is the throughput of the stage
+//      and `depth` grows if the stage is the bottleneck
+struct pipeline_stats final
+{
+    uint64_t input_count;  // values taken from the input link
+    uint64_t output_count; // values given to the next link or the sink
+    uint64_t depth;        // values waiting in the input link
+};
+
+namespace internal
+{
+// - Note
+//      Counters of a stage which owns a frame.
+//      Updated by the stage only, so relaxed order is enough
+struct stage_counter final
+{
+    std::atomic<uint64_t> taken{};
+    std::atomic<uint64_t> given{};
+};
+
+// - Note
+//      Shared by the pipeline and its stages.
+//      The stages are added before the first write
+struct pipeline_state final
+{
+    std::atomic<uint64_t> pushed{}; // writes to the first link
+    std::deque<stage_counter> stages{};
+};
+
+// - Note
+//      Fused stateless stages. The value is dropped if `nullopt`
+template <typename T>
+struct pass_through final
+{
+    auto operator()(T&& value) const noexcept(false) -> std::optional<T>
+    {
+        return std::move(value);
+    }
+};
+} // namespace internal
+
+// - Note
+//      Stages which are not started yet.
+//      `In` is the value type of the input link, and
+//      `Fn` is the fused stages from `In` to `std::optional<Out>`.
+//      Each step consumes the stage. Use `std::move` for a named one
+template <typename In, typename Out, typename Fn, size_t N, typename Lockable>
+class pipeline_stage final
+{
+  public:
+    template <typename T>
+    using link_type = buffered_channel<T, N, Lockable>;
+
+  private:
+    std::shared_ptr<internal::pipeline_state> state;
+    std::shared_ptr<link_type<In>> input;
+    Fn fn;
+
+  public:
+    pipeline_stage(std::shared_ptr<internal::pipeline_state> s,
+                   std::shared_ptr<link_type<In>> in, Fn f) noexcept(false)
+        : state{std::move(s)}, input{std::move(in)}, fn{std::move(f)}
+    {
+    }
+
+  private:
+    // - Note
+    //      Read and process until the input link is closed.
+    //      The frame holds the links and the counters,
+    //      so they live until it returns
+    template <typename Sink>
+    static auto run_sink(std::shared_ptr<internal::pipeline_state> state,
+                         std::shared_ptr<link_type<In>> input, Fn fn,
+                         Sink sink,
+                         internal::stage_counter* counter) -> return_ignore
+    {
+        while (true)
+        {
+            auto [value, ok] = co_await input->read();
+            if (ok == false)
+                co_return;
+
+            counter->taken.fetch_add(1, std::memory_order_relaxed);
+            if (auto result = fn(std::move(value)))
+            {
+                sink(std::move(*result));
+                counter->given.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    static auto run_batch(std::shared_ptr<internal::pipeline_state> state,
+                          std::shared_ptr<link_type<In>> input, Fn fn,
+                          std::shared_ptr<link_type<std::vector<Out>>> output,
+                          size_t size,
+                          internal::stage_counter* counter) -> return_ignore
+    {
+        std::vector<Out> values{};
+        values.reserve(size);
+        while (true)
+        {
+            auto [value, ok] = co_await input->read();
+            if (ok == false)
+                break;
+
+            counter->taken.fetch_add(1, std::memory_order_relaxed);
+            if (auto result = fn(std::move(value)))
+                values.emplace_back(std::move(*result));
+            if (values.size() < size)
+                continue;
+
+            if (co_await output->write(values) == false)
+                co_return;
+            counter->given.fetch_add(1, std::memory_order_relaxed);
+            values.clear();
+            values.reserve(size);
+        }
+        // flush the last one and let the next stage finish
+        if (values.empty() == false && co_await output->write(values))
+            counter->given.fetch_add(1, std::memory_order_relaxed);
+        output->close();
+    }
+
+    template <typename G>
+    auto then(G&& g) && noexcept(false)
+    {
+        using fused_t = std::decay_t<G>;
+        using result_t = std::invoke_result_t<fused_t&, In&&>;
+        return pipeline_stage<In, typename result_t::value_type, fused_t, N,
+                              Lockable>{std::move(state), std::move(input),
+                                        std::forward<G>(g)};
+    }
+
+  public:
+    // - Note
+    //      Fused into the next stage which owns a frame
+    template <typename F>
+    auto map(F f) && noexcept(false)
+    {
+        using result_t = std::invoke_result_t<F&, Out&&>;
+        return std::move(*this).then([fn = std::move(fn), f = std::move(f)](In&& value) mutable
+                    -> std::optional<result_t> {
+            auto result = fn(std::move(value));
+            if (result.has_value() == false)
+                return std::nullopt;
+            return f(std::move(*result));
+        });
+    }
+    // - Note
+    //      Fused into the next stage which owns a frame.
+    //      The value is dropped if the predicate returns `false`
+    template <typename P>
+    auto filter(P pred) && noexcept(false)
+    {
+        return std::move(*this).then([fn = std::move(fn), pred = std::move(pred)](
+                        In&& value) mutable -> std::optional<Out> {
+            auto result = fn(std::move(value));
+            if (result.has_value() && pred(std::as_const(*result)) == false)
+                return std::nullopt;
+            return result;
+        });
+    }
+    // - Note
+    //      Start a stage which groups the values by the size.
+    //      The last group can be smaller.
+    //      Its output link holds N groups
+    auto batch(size_t size) && noexcept(false)
+    {
+        using group_t = std::vector<Out>;
+        auto output = std::make_shared<link_type<group_t>>();
+        auto* counter = std::addressof(state->stages.emplace_back());
+        run_batch(state, std::move(input), std::move(fn), output,
+                  std::max<size_t>(size, 1), counter);
+
+        return pipeline_stage<group_t, group_t,
+                              internal::pass_through<group_t>, N, Lockable>{
+            std::move(state), std::move(output), {}};
+    }
+    // - Note
+    //      Start the last stage.
+    //      The function is invoked in the thread which resumed the stage
+    template <typename Sink>
+    void sink(Sink f) && noexcept(false)
+    {
+        auto* counter = std::addressof(state->stages.emplace_back());
+        run_sink(std::move(state), std::move(input), std::move(fn),
+                 std::move(f), counter);
+    }
+};
+
+// - Note
+//      Entry of the pipeline.
+//      Build the stages with `map`, `filter`, `batch`, `sink`, and then
+//      write the values. The stages finish after `close` in order.
+//      Every link between the stages is `buffered_channel<?, N, Lockable>`,
+//      so a slow stage makes the previous ones wait
+template <typename T, size_t N, typename Lockable>
+class pipeline final
+{
+  public:
+    using value_type = T;
+    using reference = T&;
+    using link_type = buffered_channel<T, N, Lockable>;
+
+  private:
+    std::shared_ptr<internal::pipeline_state> state;
+    std::shared_ptr<link_type> input;
+
+  private:
+    // - Note
+    //      Count the values in the first link
+    class counted_writer final
+    {
+        buffered_writer<T, N, Lockable> node;
+        std::atomic<uint64_t>* pushed;
+
+      public:
+        counted_writer(buffered_writer<T, N, Lockable>&& w,
+                       std::atomic<uint64_t>& counter) noexcept(false)
+            : node{std::move(w)}, pushed{std::addressof(counter)}
+        {
+        }
+
+      public:
+        bool await_ready() noexcept(false)
+        {
+            return node.await_ready();
+        }
+        template <typename P>
+        void await_suspend(
+            std::experimental::coroutine_handle<P> coro) noexcept(false)
+        {
+            return node.await_suspend(coro);
+        }
+        bool await_resume() noexcept(false)
+        {
+            if (node.await_resume() == false)
+                return false;
+            pushed->fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    };
+
+    auto stage() noexcept(false)
+    {
+        return pipeline_stage<T, T, internal::pass_through<T>, N, Lockable>{
+            state, input, {}};
+    }
+
+  public:
+    pipeline() noexcept(false)
+        : state{std::make_shared<internal::pipeline_state>()},
+          input{std::make_shared<link_type>()}
+    {
+    }
+    pipeline(const pipeline&) = delete;
+    pipeline(pipeline&&) = delete;
+    pipeline& operator=(const pipeline&) = delete;
+    pipeline& operator=(pipeline&&) = delete;
+
+    // - Note
+    //      The stages finish the remaining values
+    ~pipeline() noexcept(false)
+    {
+        close();
+    }
+
+  public:
+    template <typename F>
+    auto map(F f) noexcept(false)
+    {
+        return stage().map(std::move(f));
+    }
+    template <typename P>
+    auto filter(P pred) noexcept(false)
+    {
+        return stage().filter(std::move(pred));
+    }
+    auto batch(size_t size) noexcept(false)
+    {
+        return stage().batch(size);
+    }
+    template <typename Sink>
+    void sink(Sink f) noexcept(false)
+    {
+        return stage().sink(std::move(f));
+    }
+
+    // - Note
+    //      Awaitable write to the first link.
+    //      `co_await` returns `false` if the pipeline is closed
+    decltype(auto) write(reference ref) noexcept(false)
+    {
+        return counted_writer{input->write(ref), state->pushed};
+    }
+    // - Note
+    //      No more write. The stages close their output links
+    //      after the remaining values
+    void close() noexcept(false)
+    {
+        input->close();
+    }
+
+    // - Note
+    //      Read the counters of the stages which own a frame.
+    //      Return the number of stages. The span can be smaller than it
+    size_t snapshot(gsl::span<pipeline_stats> stats) const noexcept
+    {
+        const auto& stages = state->stages;
+        uint64_t pushed = state->pushed.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < stages.size(); ++i)
+        {
+            const auto taken = stages[i].taken.load(std::memory_order_relaxed);
+            const auto given = stages[i].given.load(std::memory_order_relaxed);
+            if (i < static_cast<size_t>(stats.size()))
+                // the counters are not read at once. don't underflow
+                stats[i] = pipeline_stats{taken, given,
+                                          pushed > taken ? pushed - taken : 0};
+            pushed = given;
+        }
+        return stages.size();
+    }
+};
+
+#endif // COROUTINE_PIPELINE_HPP
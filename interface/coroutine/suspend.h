@@ -32,7 +32,9 @@
 #ifndef COROUTINE_SUSPEND_HELPER_TYPES_H
 #define COROUTINE_SUSPEND_HELPER_TYPES_H
 
+#include <chrono>
 #include <coroutine/frame.h>
+#include <gsl/gsl>
 
 using coroutine_task_t = std::experimental::coroutine_handle<void>;
 
@@ -53,6 +55,21 @@ class suspend_hook final : public std::experimental::suspend_always,
 };
 static_assert(sizeof(suspend_hook) == sizeof(coroutine_task_t));
 
+// - Note
+//      Snapshot of `suspend_queue` counters.
+//      The library must be built with `USE_SUSPEND_QUEUE_STATS`.
+//      `push_count - pop_count` is the depth of the queue
+struct suspend_queue_stats final
+{
+    static constexpr size_t bucket_count = 32;
+
+    uint64_t push_count;
+    uint64_t pop_count;
+    uint64_t retry_count; // push retries because the queue was full
+    // time from push to pop. bucket `i` counts [2^i, 2^(i+1)) nanoseconds
+    uint64_t latency[bucket_count];
+};
+
 // - Note
 //      Interface to suspend coroutines and fetch them *manually*.
 class suspend_queue final
@@ -60,6 +77,30 @@ class suspend_queue final
     // reserve enough size to provide platform compatibility
     const uint64_t storage[8]{};
 
+  public:
+    using duration = std::chrono::microseconds;
+
+  public:
+    // - Note
+    //      Backend of the queue. It can't be changed after construction
+    enum class mode : uint32_t
+    {
+        lock_cond = 0, // lock + condition variable. default
+        lock_free = 1, // lock-free bounded MPMC ring
+        unbounded = 2, // lock + condition variable. growable segments
+        priority = 3,  // lock + condition variable. multi-level lists
+        sharded = 4,   // per-processor segment lists. prefer local shard
+        spsc = 5,      // wait-free ring. 1 pushing and 1 popping thread only
+        event = 6,     // segment lists. `wait_io_tasks` yields the pushed
+                       // coroutines. Linux only. throws system_error on
+                       // other platforms
+    };
+
+    // - Note
+    //      Levels for `mode::priority`. 0 is the most urgent.
+    //      `push` without priority uses the middle level
+    static constexpr uint32_t priority_levels = 8;
+
   public:
     suspend_queue(suspend_queue&&) noexcept = delete;
     suspend_queue& operator=(suspend_queue&&) noexcept = delete;
@@ -67,11 +108,53 @@ class suspend_queue final
     suspend_queue& operator=(const suspend_queue&) noexcept = delete;
 
     _INTERFACE_ suspend_queue() noexcept(false);
+    _INTERFACE_ explicit suspend_queue(mode m) noexcept(false);
+    // - Note
+    //      Capacity for `mode::lock_cond`. The queue takes the smallest
+    //      of 2^9, 2^12, 2^16, 2^20, 2^22 slots which can hold it,
+    //      so 100k gets 2^20. Over 2^22 throws `std::length_error`.
+    //      0 means the default(512). The other modes ignore it
+    _INTERFACE_ suspend_queue(mode m, size_t capacity) noexcept(false);
     _INTERFACE_ ~suspend_queue() noexcept;
 
     _INTERFACE_ void push(coroutine_task_t coro) noexcept(false);
+    _INTERFACE_ void push(coroutine_task_t coro,
+                          uint32_t priority) noexcept(false);
     _INTERFACE_ bool try_pop(coroutine_task_t& coro) noexcept;
 
+    // - Note
+    //      Push all coroutines in the span.
+    //      The lock and notification are shared in the batch
+    _INTERFACE_ void push_n(gsl::span<coroutine_task_t> coros) noexcept(false);
+    // - Note
+    //      Pop coroutines as many as the span can hold.
+    //      The span is shrinked to the popped coroutines
+    _INTERFACE_ bool try_pop_n(gsl::span<coroutine_task_t>& coros) noexcept;
+
+    // - Note
+    //      Blocking pop. Spin for a short time, then park the thread
+    //      until a coroutine is pushed or the timeout expires
+    _INTERFACE_ bool wait_pop(coroutine_task_t& coro,
+                              duration timeout) noexcept;
+
+    // - Note
+    //      Pop and resume coroutines until the queue is empty or
+    //      the budget is exhausted. Time is checked before each pop,
+    //      including the first one, so zero `max_time` resumes nothing.
+    //      A long coroutine can exceed it.
+    //      Return the number of resumed coroutines
+    _INTERFACE_ size_t resume_batch(size_t max_count,
+                                    duration max_time) noexcept(false);
+
+    // - Note
+    //      Num of coroutines popped from the consumer's own shard and from
+    //      the other shards. Return `false` if the mode is not `sharded`
+    _INTERFACE_ bool locality(uint64_t& local, uint64_t& remote) noexcept;
+
+    // - Note
+    //      Read the counters. Return `false` if they are compiled out
+    _INTERFACE_ bool snapshot(suspend_queue_stats& stats) const noexcept;
+
     // - Note
     //      Return an awaitable that enqueue the coroutine
     //      Relay code will be generated with this header to minimize dllexport
@@ -96,6 +179,184 @@ class suspend_queue final
         static_assert(sizeof(redirect_to) == sizeof(void*));
         return redirect_to{*this};
     }
+
+    // - Note
+    //      Return an awaitable that enqueue the coroutine with priority.
+    //      The priority is meaningful only for `mode::priority`
+    auto wait(uint32_t priority) noexcept
+    {
+        class redirect_to final : public std::experimental::suspend_always
+        {
+            suspend_queue& sq;
+            uint32_t priority;
+
+          public:
+            redirect_to(suspend_queue& q, uint32_t p) noexcept
+                : sq{q}, priority{p}
+            {
+            }
+            // override `suspend_always::await_suspend`
+            void await_suspend(coroutine_task_t coro) noexcept(false)
+            {
+                return sq.push(coro, priority);
+            }
+        };
+        return redirect_to{*this, priority};
+    }
+};
+
+// - Note
+//      Bind the current thread to the processor.
+//      With `suspend_queue::mode::sharded`, the thread's coroutines stay in
+//      the processor's shard. Darwin uses the index only as a hint
+_INTERFACE_ bool pin_current_thread(uint32_t cpu) noexcept;
+
+// - Note
+//      Work-stealing scheduler for coroutines.
+//      Each worker thread owns a deque and idle workers steal from siblings.
+//      Coroutines pushed from non-worker threads go to a shared queue
+class thread_pool final
+{
+    // reserve enough size to provide platform compatibility
+    const uint64_t storage[2]{};
+
+  public:
+    thread_pool(thread_pool&&) noexcept = delete;
+    thread_pool& operator=(thread_pool&&) noexcept = delete;
+    thread_pool(const thread_pool&) noexcept = delete;
+    thread_pool& operator=(const thread_pool&) noexcept = delete;
+
+    // - Note
+    //      Start worker threads. 0 means the number of hardware threads
+    _INTERFACE_ explicit thread_pool(uint32_t count = 0) noexcept(false);
+    // - Note
+    //      Resume all remaining coroutines, then join the workers
+    _INTERFACE_ ~thread_pool() noexcept;
+
+    _INTERFACE_ void push(coroutine_task_t coro) noexcept(false);
+
+    // - Note
+    //      Return an awaitable that moves the coroutine to a worker thread
+    auto schedule() noexcept
+    {
+        class redirect_to final : public std::experimental::suspend_always
+        {
+            thread_pool& pool;
+
+          public:
+            redirect_to(thread_pool& p) noexcept : pool{p}
+            {
+            }
+            // override `suspend_always::await_suspend`
+            void await_suspend(coroutine_task_t coro) noexcept(false)
+            {
+                return pool.push(coro);
+            }
+        };
+        static_assert(sizeof(redirect_to) == sizeof(void*));
+        return redirect_to{*this};
+    }
+};
+
+// - Note
+//      Intrusive node of `timer_wheel`.
+//      It is embedded in the awaitable, so insertion doesn't allocate
+struct timer_node
+{
+    timer_node* prev = nullptr;
+    timer_node* next = nullptr; // `nullptr` if not in the wheel
+    uint64_t deadline = 0;      // in ticks
+    void* frame = nullptr;      // coroutine to resume on expiry
+};
+
+// - Note
+//      Hierarchical timing wheel. 1 tick is 1 millisecond.
+//      Insertion and cancellation are O(1).
+//      Expired coroutines are delivered to `suspend_queue`,
+//      or to the caller's span for the I/O loop
+class timer_wheel final
+{
+    // reserve enough size to provide platform compatibility
+    const uint64_t storage[2]{};
+
+  public:
+    using clock_type = std::chrono::steady_clock;
+    using time_point = clock_type::time_point;
+    using duration = std::chrono::milliseconds;
+
+  public:
+    timer_wheel(timer_wheel&&) noexcept = delete;
+    timer_wheel& operator=(timer_wheel&&) noexcept = delete;
+    timer_wheel(const timer_wheel&) noexcept = delete;
+    timer_wheel& operator=(const timer_wheel&) noexcept = delete;
+
+    _INTERFACE_ timer_wheel() noexcept(false);
+    _INTERFACE_ ~timer_wheel() noexcept;
+
+    _INTERFACE_ void insert(timer_node& node, time_point until,
+                            coroutine_task_t coro) noexcept;
+    // - Note
+    //      Return `false` if the node is already expired or not inserted
+    _INTERFACE_ bool cancel(timer_node& node) noexcept;
+
+    // - Note
+    //      Advance the wheel to current time and
+    //      push all expired coroutines to the queue.
+    //      Return the number of them
+    _INTERFACE_ size_t expire(suspend_queue& sq) noexcept(false);
+    // - Note
+    //      Advance the wheel to current time and
+    //      fetch expired coroutines as many as the span can hold.
+    //      The span is shrinked to the fetched coroutines
+    _INTERFACE_ bool expire(gsl::span<coroutine_task_t>& coros) noexcept;
+
+    // - Note
+    //      Time until the nearest expiry. It never exceeds the actual one,
+    //      so it can be used as timeout of I/O polling.
+    //      `duration::max()` if there is no timer
+    _INTERFACE_ auto next_timeout() noexcept -> duration;
+
+    // - Note
+    //      Return an awaitable which resumes after the time point
+    auto sleep_until(time_point until) noexcept
+    {
+        class sleep_awaitable final : public timer_node
+        {
+            timer_wheel& wheel;
+            time_point until;
+
+          public:
+            sleep_awaitable(timer_wheel& w, time_point tp) noexcept
+                : timer_node{}, wheel{w}, until{tp}
+            {
+            }
+            ~sleep_awaitable() noexcept
+            {
+                // the frame is destroyed before the expiry
+                if (this->next)
+                    wheel.cancel(*this);
+            }
+
+            bool await_ready() const noexcept
+            {
+                return until <= clock_type::now();
+            }
+            void await_suspend(coroutine_task_t coro) noexcept
+            {
+                return wheel.insert(*this, until, coro);
+            }
+            void await_resume() noexcept
+            {
+            }
+        };
+        return sleep_awaitable{*this, until};
+    }
+    // - Note
+    //      Return an awaitable which resumes after the duration
+    auto sleep_for(duration d) noexcept
+    {
+        return sleep_until(clock_type::now() + d);
+    }
 };
 
 #endif // COROUTINE_SUSPEND_HELPER_TYPES_H
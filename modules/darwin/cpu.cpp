@@ -0,0 +1,38 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+//  Note
+//      Darwin doesn't expose the processor index nor hard affinity.
+//      Remember the requested index and use it as a hint
+//
+// ---------------------------------------------------------------------------
+#include <coroutine/suspend.h>
+
+#include "suspend/cpu.h"
+
+#include <functional>
+
+using namespace std;
+
+thread_local uint32_t pinned_cpu = UINT32_MAX;
+
+uint32_t current_cpu() noexcept
+{
+    if (pinned_cpu != UINT32_MAX)
+        return pinned_cpu;
+
+    // stable for the thread, so its coroutines stay in one shard
+    const auto h = hash<thread::id>{}(this_thread::get_id());
+    return static_cast<uint32_t>(h % cpu_count());
+}
+
+bool pin_current_thread(uint32_t cpu) noexcept
+{
+    if (cpu >= cpu_count())
+        return false;
+
+    pinned_cpu = cpu;
+    return true;
+}
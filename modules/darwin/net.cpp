@@ -10,6 +10,8 @@
 #include <sys/event.h>
 #include <unistd.h>
 
+#include "suspend/message_queue.h"
+
 static_assert(sizeof(ssize_t) <= sizeof(int64_t));
 using namespace std;
 using namespace std::chrono;
@@ -39,6 +41,14 @@ struct kqueue_data_t
 
 kqueue_data_t kq{};
 
+auto create_event_queue(queue_stats_t&) noexcept(false)
+    -> unique_ptr<messaging_queue_t>
+{
+    // kqueue can do the same with EVFILT_USER. not implemented yet
+    throw system_error{make_error_code(errc::function_not_supported),
+                       "event queue requires Linux eventfd"};
+}
+
 auto wait_io_tasks(nanoseconds timeout) noexcept(false)
     -> enumerable<coroutine_task_t>
 {
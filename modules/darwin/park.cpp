@@ -0,0 +1,60 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+//  Note
+//      There is no public futex API for Darwin.
+//      Emulate it with hashed buckets of condition variables
+//
+// ---------------------------------------------------------------------------
+#include "suspend/park.h"
+
+#include <array>
+#include <condition_variable>
+#include <mutex>
+
+using namespace std;
+using namespace std::chrono;
+
+struct bucket_t final
+{
+    mutex mtx{};
+    condition_variable cv{};
+};
+
+auto bucket_of(const atomic<uint32_t>& word) noexcept -> bucket_t&
+{
+    static array<bucket_t, 64> buckets{};
+
+    const auto key = reinterpret_cast<uintptr_t>(addressof(word));
+    return buckets[(key >> 4) % buckets.size()];
+}
+
+void park_on(atomic<uint32_t>& word, uint32_t expected,
+             microseconds timeout) noexcept
+{
+    auto& b = bucket_of(word);
+    unique_lock lck{b.mtx};
+    // waker changes the word before it takes the lock
+    if (word.load(memory_order_acquire) != expected)
+        return;
+
+    if (timeout == microseconds::max())
+        b.cv.wait(lck);
+    else
+        b.cv.wait_for(lck, timeout);
+}
+
+void unpark_one(atomic<uint32_t>& word) noexcept
+{
+    // the bucket can be shared by other words. wake them all
+    unpark_all(word);
+}
+
+void unpark_all(atomic<uint32_t>& word) noexcept
+{
+    auto& b = bucket_of(word);
+    unique_lock lck{b.mtx};
+    b.cv.notify_all();
+}
@@ -14,10 +14,24 @@ PRIVATE
 
     suspend/circular_queue.hpp
     suspend/message_queue.h
+    suspend/queue_stats.h
+    suspend/segment_list.hpp
+    suspend/work_stealing_deque.hpp
     suspend/lock_cond_queue.cpp
+    suspend/lock_free_queue.cpp
+    suspend/segment_queue.cpp
+    suspend/priority_queue.cpp
+    suspend/sharded_queue.cpp
+    suspend/spsc_queue.cpp
+    suspend/thread_pool.cpp
+    suspend/timer_wheel.cpp
     suspend/section.h
+    suspend/cpu.h
+    suspend/park.h
     suspend/queue.cpp
     linux/section.cpp
+    linux/park.cpp
+    linux/cpu.cpp
 
     net/resolver.cpp
     linux/net.cpp
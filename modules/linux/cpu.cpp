@@ -0,0 +1,30 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+// ---------------------------------------------------------------------------
+#include <coroutine/suspend.h>
+
+#include "suspend/cpu.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+uint32_t current_cpu() noexcept
+{
+    const auto cpu = sched_getcpu();
+    // ENOSYS: treat as the first processor
+    return cpu < 0 ? 0 : static_cast<uint32_t>(cpu);
+}
+
+bool pin_current_thread(uint32_t cpu) noexcept
+{
+    if (cpu >= CPU_SETSIZE)
+        return false;
+
+    cpu_set_t set{};
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
@@ -6,14 +6,78 @@
 // ---------------------------------------------------------------------------
 #include <coroutine/net.h>
 
+#include <array>
+#include <atomic>
+#include <climits>
 #include <fcntl.h>
+#include <poll.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 
+#include "suspend/message_queue.h"
+#include "suspend/queue_stats.h"
+#include "suspend/section.h"
+#include "suspend/segment_list.hpp"
+
 static_assert(sizeof(ssize_t) <= sizeof(int64_t));
 using namespace std;
 using namespace std::chrono;
 
+// - Note
+//      Unbounded queue which signals its eventfd on push.
+//      The eventfd is registered in the epoll instances of this file,
+//      so `wait_io_tasks` wakes up for both I/O and pushed coroutines.
+//      Pushes are coalesced. Only the first one after drain writes to it
+class event_queue_t final : public messaging_queue_t
+{
+  private:
+    section cs{};
+    segment_list_t<message_t> sl{};
+    size_t count = 0; // num of messages in `sl`
+    atomic<bool> signaled{};
+    int efd = -1;
+    queue_stats_t* stats; // of the owner `suspend_queue`
+
+  public:
+    explicit event_queue_t(queue_stats_t& s) noexcept(false);
+    ~event_queue_t() noexcept;
+
+    bool post(message_t msg) noexcept override;
+    bool peek(message_t& msg) noexcept override;
+    bool wait(message_t& msg, duration timeout) noexcept override;
+
+    size_t post_n(gsl::span<const message_t> msgs) noexcept override;
+    size_t peek_n(gsl::span<message_t> msgs) noexcept override;
+
+    // - Note
+    //      Consume the signal before draining the queue.
+    //      Pushes after this will signal again.
+    //      Return the num of messages to drain for this signal
+    size_t reset() noexcept;
+    // - Note
+    //      Pop for `wait_io_tasks`. Same with `suspend_queue::try_pop_n`
+    size_t drain(gsl::span<message_t> msgs) noexcept;
+
+  private:
+    void signal() noexcept;
+};
+
+// - Note
+//      `epoll_event.data.ptr` is a coroutine frame or a tagged queue.
+//      Frames are aligned, so the lowest bit is available for the tag
+auto tag_of(event_queue_t* q) noexcept -> void*
+{
+    return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(q) | 1);
+}
+auto as_event_queue(void* ptr) noexcept -> event_queue_t*
+{
+    const auto v = reinterpret_cast<uintptr_t>(ptr);
+    if ((v & 1) == 0)
+        return nullptr;
+    return reinterpret_cast<event_queue_t*>(v & ~uintptr_t{1});
+}
+
 struct event_data_t
 {
     int fd;
@@ -69,6 +133,27 @@ struct event_data_t
         for (auto i = 0; i < count; ++i)
         {
             auto& ev = events[i];
+            if (auto* q = as_event_queue(ev.data.ptr))
+            {
+                // yield the coroutines pushed before the reset.
+                // the yielded ones can push again. they signal again and
+                // are popped in the next wait, so this doesn't livelock
+                array<message_t, 64> msgs{};
+                for (auto remain = q->reset(); remain > 0;)
+                {
+                    const auto n = q->drain(gsl::span<message_t>{msgs}.first(
+                        min(remain, msgs.size())));
+                    if (n == 0)
+                        break; // the others popped them
+                    remain -= n;
+                    for (size_t k = 0; k < n; ++k)
+                    {
+                        auto task = coroutine_task_t::from_address(msgs[k].ptr);
+                        co_yield task;
+                    }
+                }
+                continue;
+            }
             auto task = coroutine_task_t::from_address(ev.data.ptr);
             co_yield task;
         }
@@ -77,14 +162,150 @@ struct event_data_t
 
 event_data_t inbound{}, outbound{};
 
+event_queue_t::event_queue_t(queue_stats_t& s) noexcept(false)
+    : stats{addressof(s)}
+{
+    efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (efd < 0)
+        throw system_error{errno, system_category(), "eventfd"};
+
+    // level-triggered. both instances report it until `reset`,
+    // so the one which is blocking now wakes up
+    epoll_event req{};
+    req.events = EPOLLIN;
+    req.data.ptr = tag_of(this);
+    try
+    {
+        inbound.try_add(efd, req);
+        outbound.try_add(efd, req);
+    }
+    catch (...)
+    {
+        close(efd);
+        throw;
+    }
+}
+
+event_queue_t::~event_queue_t() noexcept
+{
+    // closing the fd removes it from the epoll instances
+    close(efd);
+}
+
+void event_queue_t::signal() noexcept
+{
+    // already signaled and not drained yet. skip the syscall
+    if (signaled.exchange(true, memory_order_seq_cst))
+        return;
+
+    const uint64_t one = 1;
+    // EAGAIN: the counter is saturated. it is readable anyway
+    static_cast<void>(write(efd, &one, sizeof(one)));
+}
+
+size_t event_queue_t::reset() noexcept
+{
+    uint64_t value = 0;
+    // EAGAIN: another loop took the signal
+    static_cast<void>(read(efd, &value, sizeof(value)));
+    signaled.store(false, memory_order_seq_cst);
+
+    unique_lock lck{cs};
+    return count;
+}
+
+size_t event_queue_t::drain(gsl::span<message_t> msgs) noexcept
+{
+    const auto n = peek_n(msgs);
+    stats->on_pop(msgs.first(n));
+    return n;
+}
+
+bool event_queue_t::post(message_t msg) noexcept
+{
+    {
+        unique_lock lck{cs};
+        if (sl.push(msg) == false)
+            return false;
+        ++count;
+    }
+    signal();
+    return true;
+}
+
+bool event_queue_t::peek(message_t& msg) noexcept
+{
+    unique_lock lck{cs};
+    if (sl.try_pop(msg) == false)
+        return false;
+    --count;
+    return true;
+}
+
+bool event_queue_t::wait(message_t& msg, duration timeout) noexcept
+{
+    msg = message_t{}; // zero the memory
+    if (peek(msg))
+        return true;
+
+    const auto ms = duration_cast<milliseconds>(timeout).count();
+    pollfd pfd{};
+    pfd.fd = efd;
+    pfd.events = POLLIN;
+    poll(&pfd, 1, ms > INT_MAX ? -1 : static_cast<int>(ms));
+    return peek(msg);
+}
+
+size_t event_queue_t::post_n(gsl::span<const message_t> msgs) noexcept
+{
+    size_t n = 0;
+    {
+        unique_lock lck{cs};
+        for (const message_t& msg : msgs)
+            if (sl.push(msg))
+                ++n;
+            else
+                break;
+        count += n;
+    }
+    // one signal for the batch
+    if (n)
+        signal();
+    return n;
+}
+
+size_t event_queue_t::peek_n(gsl::span<message_t> msgs) noexcept
+{
+    size_t n = 0;
+    unique_lock lck{cs};
+    for (message_t& msg : msgs)
+        if (sl.try_pop(msg))
+            ++n;
+        else
+            break;
+    count -= n;
+    return n;
+}
+
+auto create_event_queue(queue_stats_t& stats) noexcept(false)
+    -> unique_ptr<messaging_queue_t>
+{
+    return make_unique<event_queue_t>(stats);
+}
+
 auto wait_io_tasks(nanoseconds timeout) noexcept(false)
     -> enumerable<coroutine_task_t>
 {
     const int half_time = duration_cast<milliseconds>(timeout).count() / 2;
 
+    size_t count = 0;
     for (auto coro : inbound.wait(half_time))
+    {
+        ++count;
         co_yield coro;
-    for (auto coro : outbound.wait(half_time))
+    }
+    // something happened. don't block again and return to the caller
+    for (auto coro : outbound.wait(count ? 0 : half_time))
         co_yield coro;
 }
 
@@ -0,0 +1,52 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+// ---------------------------------------------------------------------------
+#include "suspend/park.h"
+
+#include <climits>
+#include <ctime>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+auto for_futex(atomic<uint32_t>& word) noexcept
+{
+    static_assert(sizeof(atomic<uint32_t>) == sizeof(uint32_t));
+    return reinterpret_cast<uint32_t*>(addressof(word));
+}
+
+void park_on(atomic<uint32_t>& word, uint32_t expected,
+             microseconds timeout) noexcept
+{
+    timespec ts{};
+    timespec* pts = nullptr;
+    if (timeout != microseconds::max())
+    {
+        ts.tv_sec = duration_cast<seconds>(timeout).count();
+        ts.tv_nsec = duration_cast<nanoseconds>(timeout % seconds{1}).count();
+        pts = addressof(ts);
+    }
+    // EAGAIN: the word is already changed
+    // ETIMEDOUT, EINTR: caller will check the condition again
+    syscall(SYS_futex, for_futex(word), FUTEX_WAIT_PRIVATE, expected, pts,
+            nullptr, 0);
+}
+
+void unpark_one(atomic<uint32_t>& word) noexcept
+{
+    syscall(SYS_futex, for_futex(word), FUTEX_WAKE_PRIVATE, 1, nullptr,
+            nullptr, 0);
+}
+
+void unpark_all(atomic<uint32_t>& word) noexcept
+{
+    syscall(SYS_futex, for_futex(word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr,
+            nullptr, 0);
+}
@@ -3,84 +3,94 @@
 //  Author  : github.com/luncliff (luncliff@gmail.com)
 //  License : CC BY 4.0
 //
+//  Reference
+//      Futexes Are Tricky (Ulrich Drepper)
+//      https://www.akkadia.org/drepper/futex.pdf
+//
 // ---------------------------------------------------------------------------
 #include "suspend/section.h"
+#include "suspend/park.h"
 
 #include <gsl/gsl>
 
-#include <pthread.h>
-#include <sys/types.h>
+using namespace std;
+using namespace std::chrono;
 
-auto for_posix(section* s) noexcept
+// - Note
+//      Adaptive mutex with futex. (`mutex3` in the reference)
+//      It spins for a short time, then parks the thread.
+//      `section` only needs exclusive lock, so there is no reader count
+struct futex_lock_t final
 {
-    static_assert(sizeof(pthread_rwlock_t) <= sizeof(section));
-    return reinterpret_cast<pthread_rwlock_t*>(s);
-}
-auto for_posix(const section* s) noexcept
+    static constexpr uint32_t unlocked = 0;
+    static constexpr uint32_t locked = 1;
+    static constexpr uint32_t contended = 2; // locked and there may be waiter
+
+    static constexpr uint32_t spin_count = 100;
+
+    atomic<uint32_t> state{unlocked};
+    // num of threads in slow path.
+    // `contended` state is sticky, so this prevents needless wake syscall
+    atomic<uint32_t> waiters{};
+};
+
+GSL_SUPPRESS(type.1)
+auto for_futex(section* s) noexcept
 {
-    static_assert(sizeof(pthread_rwlock_t) <= sizeof(section));
-    return reinterpret_cast<const pthread_rwlock_t*>(s);
+    static_assert(sizeof(futex_lock_t) <= sizeof(section));
+    return reinterpret_cast<futex_lock_t*>(s);
 }
 
 section::section() noexcept(false) : storage{}
 {
-    auto* rwlock = for_posix(this);
-
-    if (auto ec = pthread_rwlock_init(rwlock, nullptr))
-        throw std::system_error{ec, std::system_category(),
-                                "pthread_rwlock_init"};
+    new (for_futex(this)) futex_lock_t{};
 }
 
 section::~section() noexcept
 {
-    auto* rwlock = for_posix(this);
-    try
-    {
-        if (auto ec = pthread_rwlock_destroy(rwlock))
-            throw std::system_error{ec, std::system_category(),
-                                    "pthread_rwlock_init"};
-    }
-    catch (const std::system_error& e)
-    {
-        ::perror(e.what());
-    }
-    catch (...)
-    {
-        ::perror("Unknown exception in section dtor");
-    }
+    for_futex(this)->~futex_lock_t();
 }
 
 bool section::try_lock() noexcept
 {
-    auto* rwlock = for_posix(this);
-    // EBUSY  // possible error
-    // EINVAL
-    // EDEADLK
-    auto ec = pthread_rwlock_trywrlock(rwlock);
-    return ec == 0;
+    auto* ft = for_futex(this);
+    uint32_t expected = futex_lock_t::unlocked;
+    return ft->state.compare_exchange_strong(expected, futex_lock_t::locked,
+                                             memory_order_acquire,
+                                             memory_order_relaxed);
 }
 
-// - Note
-//
-//  There was an issue with `pthread_mutex_`
-//  it returned EINVAL for lock operation
-//  replacing it the rwlock
-//
 void section::lock() noexcept(false)
 {
-    auto* rwlock = for_posix(this);
+    if (try_lock())
+        return;
 
-    if (auto ec = pthread_rwlock_wrlock(rwlock))
-        // EINVAL ?
-        throw std::system_error{ec, std::system_category(),
-                                "pthread_rwlock_wrlock"};
+    auto* ft = for_futex(this);
+    // spin while the owner is likely to release it soon.
+    // read before CAS not to bounce the cache line
+    for (uint32_t i = 0; i < futex_lock_t::spin_count; ++i)
+    {
+        spin_pause();
+        if (ft->state.load(memory_order_relaxed) == futex_lock_t::unlocked &&
+            try_lock())
+            return;
+    }
+
+    ft->waiters.fetch_add(1, memory_order_seq_cst);
+    // mark contended. if it was unlocked, we own the lock now
+    while (ft->state.exchange(futex_lock_t::contended, memory_order_acquire) !=
+           futex_lock_t::unlocked)
+        park_on(ft->state, futex_lock_t::contended, microseconds::max());
+    ft->waiters.fetch_sub(1, memory_order_relaxed);
 }
 
 void section::unlock() noexcept(false)
 {
-    auto* rwlock = for_posix(this);
-
-    if (auto ec = pthread_rwlock_unlock(rwlock))
-        throw std::system_error{ec, std::system_category(),
-                                "pthread_rwlock_unlock"};
+    auto* ft = for_futex(this);
+    if (ft->state.exchange(futex_lock_t::unlocked, memory_order_seq_cst) !=
+        futex_lock_t::contended)
+        return;
+    // skip the syscall if the waiters already left
+    if (ft->waiters.load(memory_order_seq_cst) > 0)
+        unpark_one(ft->state);
 }
@@ -7,46 +7,51 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 
-template <typename ElemType>
+// - Note
+//      Capacity must be power of 2, so the index is wrapped with mask.
+//      `begin` and `end` increase without wrapping and
+//      their difference is the number of elements.
+//      So all slots are usable and there is no division
+template <typename ElemType, size_t Capacity = 512>
 class bounded_circular_queue_t
 {
-    static constexpr auto capacity = 500 + 1;
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "capacity must be power of 2");
 
   public:
     using value_type = ElemType;
-    using index_type = uint16_t;
+    using index_type = uint64_t;
+
+    static constexpr size_t capacity = Capacity;
+    static constexpr index_type mask = Capacity - 1;
 
   private:
     index_type begin = 0;
     index_type end = 0;
     std::array<value_type, capacity> storage{};
 
-  public:
-    static index_type next(index_type i) noexcept
-    {
-        return (i + 1) % capacity;
-    }
-
   public:
     bool is_full() const noexcept
     {
-        return next(end) == begin;
+        return end - begin == capacity;
     }
     bool empty() const noexcept
     {
         return begin == end;
     }
+    size_t size() const noexcept
+    {
+        return static_cast<size_t>(end - begin);
+    }
 
     bool push(const value_type& msg) noexcept
     {
         if (is_full())
             return false;
 
-        const auto index = end;
-        end = next(end); // increase count;
-
-        storage.at(index) = msg; // expect copy
+        storage[end++ & mask] = msg; // expect copy
         return true;
     }
 
@@ -55,10 +60,7 @@ class bounded_circular_queue_t
         if (empty())
             return false;
 
-        const auto index = begin;
-        begin = next(begin); // decrease count;
-
-        msg = std::move(storage.at(index)); // expect move
+        msg = std::move(storage[begin++ & mask]); // expect move
         return true;
     }
 };
@@ -0,0 +1,27 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+//  Note
+//      Processor index of the current thread.
+//      Linux and Windows ask the OS. Darwin has no such API,
+//      so it uses the pinned index or a stable hash of the thread
+//
+// ---------------------------------------------------------------------------
+#pragma once
+#include <cstdint>
+#include <thread>
+
+// - Note
+//      Index of the processor which is running the current thread.
+//      The value can be stale right after the return
+uint32_t current_cpu() noexcept;
+
+// - Note
+//      Num of processors. At least 1
+inline uint32_t cpu_count() noexcept
+{
+    const auto count = std::thread::hardware_concurrency();
+    return count ? count : 1;
+}
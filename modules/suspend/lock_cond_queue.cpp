@@ -8,6 +8,7 @@
 
 #include <array>
 #include <condition_variable>
+#include <stdexcept>
 
 #include "suspend/circular_queue.hpp"
 #include "suspend/message_queue.h"
@@ -15,22 +16,25 @@
 
 using namespace std;
 
+template <size_t Capacity>
 class lock_cond_queue_t final : public messaging_queue_t
 {
-    static constexpr auto capacity = 500 + 1;
-
   private:
     section cs{};
     condition_variable_any cv{};
-    bounded_circular_queue_t<message_t> cq{};
+    bounded_circular_queue_t<message_t, Capacity> cq{};
 
   public:
     bool post(message_t msg) noexcept override;
     bool peek(message_t& msg) noexcept override;
     bool wait(message_t& msg, duration timeout) noexcept override;
+
+    size_t post_n(gsl::span<const message_t> msgs) noexcept override;
+    size_t peek_n(gsl::span<message_t> msgs) noexcept override;
 };
 
-bool lock_cond_queue_t::post(message_t msg) noexcept
+template <size_t Capacity>
+bool lock_cond_queue_t<Capacity>::post(message_t msg) noexcept
 {
     unique_lock lck{cs};
     if (cq.push(msg) == true)
@@ -41,13 +45,16 @@ bool lock_cond_queue_t::post(message_t msg) noexcept
     return false;
 }
 
-bool lock_cond_queue_t::peek(message_t& msg) noexcept
+template <size_t Capacity>
+bool lock_cond_queue_t<Capacity>::peek(message_t& msg) noexcept
 {
     unique_lock lck{cs};
     return cq.try_pop(msg);
 }
 
-bool lock_cond_queue_t::wait(message_t& msg, duration timeout) noexcept
+template <size_t Capacity>
+bool lock_cond_queue_t<Capacity>::wait(message_t& msg,
+                                       duration timeout) noexcept
 {
     msg = message_t{}; // zero the memory
 
@@ -58,7 +65,55 @@ bool lock_cond_queue_t::wait(message_t& msg, duration timeout) noexcept
     return cq.try_pop(msg);
 }
 
-auto create_message_queue() noexcept(false) -> unique_ptr<messaging_queue_t>
+template <size_t Capacity>
+size_t lock_cond_queue_t<Capacity>::post_n(
+    gsl::span<const message_t> msgs) noexcept
+{
+    size_t count = 0;
+    unique_lock lck{cs};
+    for (const message_t& msg : msgs)
+        if (cq.push(msg))
+            ++count;
+        else
+            break;
+
+    // notify once for the batch
+    if (count == 1)
+        cv.notify_one();
+    else if (count > 1)
+        cv.notify_all();
+    return count;
+}
+
+template <size_t Capacity>
+size_t lock_cond_queue_t<Capacity>::peek_n(
+    gsl::span<message_t> msgs) noexcept
+{
+    size_t count = 0;
+    unique_lock lck{cs};
+    for (message_t& msg : msgs)
+        if (cq.try_pop(msg))
+            ++count;
+        else
+            break;
+    return count;
+}
+
+auto create_message_queue(size_t capacity) noexcept(false)
+    -> unique_ptr<messaging_queue_t>
 {
-    return make_unique<lock_cond_queue_t>();
+    // - Note
+    //      Use the smallest instantiation which can hold the capacity.
+    //      Large ones are allocated in heap with the queue
+    if (capacity <= (1 << 9))
+        return make_unique<lock_cond_queue_t<1 << 9>>();
+    if (capacity <= (1 << 12))
+        return make_unique<lock_cond_queue_t<1 << 12>>();
+    if (capacity <= (1 << 16))
+        return make_unique<lock_cond_queue_t<1 << 16>>();
+    if (capacity <= (1 << 20))
+        return make_unique<lock_cond_queue_t<1 << 20>>();
+    if (capacity <= (1 << 22))
+        return make_unique<lock_cond_queue_t<1 << 22>>();
+    throw length_error{"capacity of message queue is too large"};
 }
@@ -0,0 +1,134 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+//  Reference
+//      Bounded MPMC queue by Dmitry Vyukov
+//      http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+//
+// ---------------------------------------------------------------------------
+#include <array>
+#include <atomic>
+#include <thread>
+
+#include "suspend/message_queue.h"
+
+using namespace std;
+using namespace std::chrono;
+
+// - Note
+//      Each slot carries a sequence number.
+//      Producer can write to the slot when `sequence == position`,
+//      and consumer can read from it when `sequence == position + 1`.
+//      So there is no lock but only one CAS for each operation
+class lock_free_queue_t final : public messaging_queue_t
+{
+    static constexpr size_t capacity = 512; // must be power of 2
+    static constexpr size_t mask = capacity - 1;
+    static_assert((capacity & mask) == 0);
+
+    struct slot_t final
+    {
+        atomic<size_t> sequence;
+        message_t msg;
+    };
+
+  private:
+    // head and tail are modified by different threads.
+    // place them in separate cache lines to prevent false sharing
+    alignas(cache_line_size) atomic<size_t> head{}; // position for pop
+    alignas(cache_line_size) atomic<size_t> tail{}; // position for push
+    alignas(cache_line_size) array<slot_t, capacity> slots;
+
+  public:
+    lock_free_queue_t() noexcept;
+
+    bool post(message_t msg) noexcept override;
+    bool peek(message_t& msg) noexcept override;
+    bool wait(message_t& msg, duration timeout) noexcept override;
+};
+
+lock_free_queue_t::lock_free_queue_t() noexcept
+{
+    for (size_t i = 0; i < capacity; ++i)
+        slots[i].sequence.store(i, memory_order_relaxed);
+}
+
+bool lock_free_queue_t::post(message_t msg) noexcept
+{
+    size_t pos = tail.load(memory_order_relaxed);
+    while (true)
+    {
+        slot_t& slot = slots[pos & mask];
+        const size_t seq = slot.sequence.load(memory_order_acquire);
+        const auto diff = static_cast<intptr_t>(seq - pos);
+
+        if (diff == 0)
+        {
+            // the slot is empty. try to reserve it
+            if (tail.compare_exchange_weak(pos, pos + 1,
+                                           memory_order_relaxed))
+            {
+                slot.msg = msg;
+                // publish to consumers
+                slot.sequence.store(pos + 1, memory_order_release);
+                return true;
+            }
+            // `pos` is updated by CAS failure. retry with it
+        }
+        else if (diff < 0)
+            return false; // consumers didn't take the slot. queue is full
+        else
+            pos = tail.load(memory_order_relaxed);
+    }
+}
+
+bool lock_free_queue_t::peek(message_t& msg) noexcept
+{
+    size_t pos = head.load(memory_order_relaxed);
+    while (true)
+    {
+        slot_t& slot = slots[pos & mask];
+        const size_t seq = slot.sequence.load(memory_order_acquire);
+        const auto diff = static_cast<intptr_t>(seq - (pos + 1));
+
+        if (diff == 0)
+        {
+            // the slot holds a message. try to take it
+            if (head.compare_exchange_weak(pos, pos + 1,
+                                           memory_order_relaxed))
+            {
+                msg = slot.msg;
+                // release the slot for the next round of producers
+                slot.sequence.store(pos + capacity, memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+            return false; // producers didn't fill the slot. queue is empty
+        else
+            pos = head.load(memory_order_relaxed);
+    }
+}
+
+bool lock_free_queue_t::wait(message_t& msg, duration timeout) noexcept
+{
+    msg = message_t{}; // zero the memory
+
+    // there is no condition variable. poll until the timeout
+    const auto until = steady_clock::now() + timeout;
+    do
+    {
+        if (peek(msg))
+            return true;
+        this_thread::yield();
+    } while (steady_clock::now() < until);
+
+    return peek(msg);
+}
+
+auto create_lock_free_queue() noexcept(false) -> unique_ptr<messaging_queue_t>
+{
+    return make_unique<lock_free_queue_t>();
+}
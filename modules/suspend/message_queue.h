@@ -4,9 +4,19 @@
 //  License : CC BY 4.0
 //
 // ---------------------------------------------------------------------------
+#pragma once
 #include <chrono>
+#include <gsl/gsl>
 #include <memory>
 
+// - Note
+//      Assume 64 byte cache line to separate hot members of queues
+static constexpr size_t cache_line_size = 64;
+
+// - Note
+//      Num of levels for priority queue. 0 is the most urgent
+static constexpr uint32_t priority_levels = 8;
+
 struct message_t final
 {
     union {
@@ -14,8 +24,13 @@ struct message_t final
         uint64_t u64;
         void* ptr;
     };
+#if defined(USE_SUSPEND_QUEUE_STATS)
+    uint64_t stamp{}; // time of push for the latency histogram
+#endif
 };
+#if !defined(USE_SUSPEND_QUEUE_STATS)
 static_assert(sizeof(message_t) == sizeof(uint64_t));
+#endif
 
 class messaging_queue_t
 {
@@ -28,7 +43,91 @@ class messaging_queue_t
     virtual bool post(message_t msg) noexcept = 0;
     virtual bool peek(message_t& msg) noexcept = 0;
     virtual bool wait(message_t& msg, duration timeout) noexcept = 0;
+
+    // - Note
+    //      Post with priority. Queues without levels ignore it
+    virtual bool post_at(message_t msg, uint32_t priority) noexcept
+    {
+        static_cast<void>(priority);
+        return post(msg);
+    }
+
+    // - Note
+    //      Batch operations. Return the number of processed messages.
+    //      By default, they repeat single message operations.
+    //      Override them to amortize the synchronization cost
+    virtual size_t post_n(gsl::span<const message_t> msgs) noexcept
+    {
+        size_t count = 0;
+        for (const message_t& msg : msgs)
+            if (post(msg))
+                ++count;
+            else
+                break;
+        return count;
+    }
+    virtual size_t peek_n(gsl::span<message_t> msgs) noexcept
+    {
+        size_t count = 0;
+        for (message_t& msg : msgs)
+            if (peek(msg))
+                ++count;
+            else
+                break;
+        return count;
+    }
+
+    // - Note
+    //      Num of messages consumed from the consumer's own shard and
+    //      from the others. Return `false` if the queue is not sharded
+    virtual bool locality(uint64_t& local, uint64_t& remote) noexcept
+    {
+        local = remote = 0;
+        return false;
+    }
 };
 
-auto create_message_queue() noexcept(false)
+// - Note
+//      Lock + condition variable over bounded circular queue.
+//      The capacity picks the smallest of 2^9, 2^12, 2^16, 2^20, 2^22.
+//      Throws `length_error` if it is larger
+auto create_message_queue(size_t capacity = 512) noexcept(false)
+    -> std::unique_ptr<messaging_queue_t>;
+
+// - Note
+//      Lock-free bounded MPMC ring
+auto create_lock_free_queue() noexcept(false)
+    -> std::unique_ptr<messaging_queue_t>;
+
+// - Note
+//      Lock + condition variable over unbounded segment list.
+//      `post` fails only when memory allocation fails
+auto create_segment_queue() noexcept(false)
+    -> std::unique_ptr<messaging_queue_t>;
+
+// - Note
+//      Lock + condition variable over multi-level lists.
+//      Pop is O(1) with bitmap of non-empty levels
+auto create_priority_queue() noexcept(false)
+    -> std::unique_ptr<messaging_queue_t>;
+
+// - Note
+//      Wait-free bounded ring for one producer and one consumer.
+//      Concurrent use from more threads is undefined
+auto create_spsc_queue() noexcept(false)
+    -> std::unique_ptr<messaging_queue_t>;
+
+class queue_stats_t;
+
+// - Note
+//      Lock over unbounded segment list. Push signals an eventfd
+//      which is polled by `wait_io_tasks`. Throws if not Linux.
+//      `wait_io_tasks` records its pops to the stats
+auto create_event_queue(queue_stats_t& stats) noexcept(false)
+    -> std::unique_ptr<messaging_queue_t>;
+
+// - Note
+//      Segment lists for each processor. Push to the current processor's
+//      shard, and pop from it before the neighbours
+auto create_sharded_queue() noexcept(false)
     -> std::unique_ptr<messaging_queue_t>;
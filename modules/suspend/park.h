@@ -0,0 +1,61 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+//  Note
+//      Address based thread parking.
+//      Linux uses futex, Windows uses WaitOnAddress.
+//      Other platforms emulate it with condition variables
+//
+// ---------------------------------------------------------------------------
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// - Note
+//      Hint for the processor in spin-wait loop
+inline void spin_pause() noexcept
+{
+#if defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// - Note
+//      Hint for the processor to load the memory into cache
+inline void prefetch(const void* ptr) noexcept
+{
+#if defined(_M_X64) || defined(_M_IX86)
+    _mm_prefetch(static_cast<const char*>(ptr), _MM_HINT_T0);
+#elif defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(ptr);
+#else
+    static_cast<void>(ptr);
+#endif
+}
+
+// - Note
+//      Block the current thread while the word holds `expected`.
+//      It can return early with spurious wake-up,
+//      so the caller must check its condition again.
+//      `duration::max()` means no timeout
+void park_on(std::atomic<uint32_t>& word, uint32_t expected,
+             std::chrono::microseconds timeout) noexcept;
+
+// - Note
+//      Wake threads parked on the word.
+//      The caller must change the word before this
+void unpark_one(std::atomic<uint32_t>& word) noexcept;
+void unpark_all(std::atomic<uint32_t>& word) noexcept;
@@ -0,0 +1,177 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+// ---------------------------------------------------------------------------
+#include <array>
+#include <condition_variable>
+
+#include "suspend/message_queue.h"
+#include "suspend/section.h"
+#include "suspend/segment_list.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+// - Note
+//      Index of the least significant set bit. `v` must not be 0
+uint32_t lowest_bit(uint32_t v) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward(&index, v);
+    return index;
+#else
+    return static_cast<uint32_t>(__builtin_ctz(v));
+#endif
+}
+
+// - Note
+//      Index of the most significant set bit. `v` must not be 0
+uint32_t highest_bit(uint32_t v) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanReverse(&index, v);
+    return index;
+#else
+    return 31 - static_cast<uint32_t>(__builtin_clz(v));
+#endif
+}
+
+// - Note
+//      FIFO for each level. Level 0 is the most urgent.
+//      The bitmap marks non-empty levels, so pop doesn't scan the lists.
+//      To prevent starvation, every `starvation_limit`-th pop serves
+//      the least urgent level if it was skipped that long
+class priority_queue_t final : public messaging_queue_t
+{
+    static constexpr uint32_t levels = priority_levels;
+    static constexpr uint32_t default_level = levels / 2;
+    static constexpr uint32_t starvation_limit = 32;
+    static_assert(levels <= 32, "bitmap can't hold the levels");
+
+  private:
+    section cs{};
+    condition_variable_any cv{};
+    array<segment_list_t<message_t, 64>, levels> lists{};
+    uint32_t bitmap = 0; // bit i is set if level i is not empty
+    uint32_t streak = 0; // num of pops while the least urgent one waited
+
+  private:
+    bool push(message_t msg, uint32_t priority) noexcept;
+    bool pop(message_t& msg) noexcept;
+
+  public:
+    bool post(message_t msg) noexcept override;
+    bool post_at(message_t msg, uint32_t priority) noexcept override;
+    bool peek(message_t& msg) noexcept override;
+    bool wait(message_t& msg, duration timeout) noexcept override;
+
+    size_t post_n(gsl::span<const message_t> msgs) noexcept override;
+    size_t peek_n(gsl::span<message_t> msgs) noexcept override;
+};
+
+bool priority_queue_t::push(message_t msg, uint32_t priority) noexcept
+{
+    const auto level = min(priority, levels - 1);
+    if (lists[level].push(msg) == false)
+        return false;
+
+    bitmap |= 1u << level;
+    return true;
+}
+
+bool priority_queue_t::pop(message_t& msg) noexcept
+{
+    if (bitmap == 0)
+        return false;
+
+    auto level = lowest_bit(bitmap);
+    const auto last = highest_bit(bitmap);
+    if (level == last)
+        streak = 0; // nothing is waiting behind
+    else if (++streak == starvation_limit)
+    {
+        level = last;
+        streak = 0;
+    }
+
+    auto& list = lists[level];
+    const bool popped = list.try_pop(msg);
+    if (list.empty())
+        bitmap &= ~(1u << level);
+    return popped;
+}
+
+bool priority_queue_t::post(message_t msg) noexcept
+{
+    return post_at(msg, default_level);
+}
+
+bool priority_queue_t::post_at(message_t msg, uint32_t priority) noexcept
+{
+    unique_lock lck{cs};
+    if (push(msg, priority) == true)
+    {
+        cv.notify_one();
+        return true;
+    }
+    return false;
+}
+
+bool priority_queue_t::peek(message_t& msg) noexcept
+{
+    unique_lock lck{cs};
+    return pop(msg);
+}
+
+bool priority_queue_t::wait(message_t& msg, duration timeout) noexcept
+{
+    msg = message_t{}; // zero the memory
+
+    unique_lock lck{cs};
+    if (bitmap == 0)
+        cv.wait_for(lck, timeout);
+
+    return pop(msg);
+}
+
+size_t priority_queue_t::post_n(gsl::span<const message_t> msgs) noexcept
+{
+    size_t count = 0;
+    unique_lock lck{cs};
+    for (const message_t& msg : msgs)
+        if (push(msg, default_level))
+            ++count;
+        else
+            break;
+
+    // notify once for the batch
+    if (count == 1)
+        cv.notify_one();
+    else if (count > 1)
+        cv.notify_all();
+    return count;
+}
+
+size_t priority_queue_t::peek_n(gsl::span<message_t> msgs) noexcept
+{
+    size_t count = 0;
+    unique_lock lck{cs};
+    for (message_t& msg : msgs)
+        if (pop(msg))
+            ++count;
+        else
+            break;
+    return count;
+}
+
+auto create_priority_queue() noexcept(false) -> unique_ptr<messaging_queue_t>
+{
+    return make_unique<priority_queue_t>();
+}
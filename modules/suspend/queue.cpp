@@ -6,16 +6,65 @@
 // ---------------------------------------------------------------------------
 #include <coroutine/suspend.h>
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <gsl/gsl>
 
 #include "suspend/message_queue.h"
+#include "suspend/park.h"
+#include "suspend/queue_stats.h"
+
+using namespace std::chrono;
 
 struct suspend_queue_impl final
 {
     std::atomic<uint32_t> ref_count{};
-    uint32_t pad1{};
+    suspend_queue::mode m{};
     std::unique_ptr<messaging_queue_t> mq{};
+
+    // for `wait_pop`
+    std::atomic<uint32_t> epoch{};    // changed when sleepers must wake
+    std::atomic<uint32_t> sleeping{}; // num of parked threads
+    std::atomic<uint32_t> spin_limit{min_spin};
+
+    queue_stats_t stats{};
+
+  public:
+    static constexpr uint32_t min_spin = 4;
+    static constexpr uint32_t max_spin = 256;
+    // longest park of `mode::spsc`. see `notify`
+    static constexpr suspend_queue::duration spsc_park_slice{1000};
+
+  public:
+    // - Note
+    //      Wake parked threads after push.
+    //      Cheap load when there is no sleeper.
+    //
+    //      `mode::spsc` skips the fence to keep its push wait-free.
+    //      Then the consumer can park just after the check and miss this,
+    //      so it parks `spsc_park_slice` at most and checks again
+    void notify(size_t count) noexcept
+    {
+        if (m == suspend_queue::mode::spsc)
+        {
+            if (sleeping.load(std::memory_order_acquire) == 0)
+                return;
+        }
+        else
+        {
+            // pushed message must be visible before checking the sleepers
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping.load(std::memory_order_relaxed) == 0)
+                return;
+        }
+
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        if (count > 1)
+            unpark_all(epoch);
+        else
+            unpark_one(epoch);
+    }
 };
 
 GSL_SUPPRESS(type.1)
@@ -26,10 +75,73 @@ auto get_impl(gsl::not_null<suspend_queue*> p) noexcept
     return reinterpret_cast<suspend_queue_impl*>(p.get());
 }
 
-suspend_queue::suspend_queue() noexcept(false) : storage{}
+// - Note
+//      `now + timeout` which doesn't overflow.
+//      `time_point::max()` for a long timeout like `duration::max()`
+auto deadline_of(suspend_queue::duration timeout) noexcept
+    -> steady_clock::time_point
+{
+    const auto now = steady_clock::now();
+    if (timeout >= duration_cast<suspend_queue::duration>(
+                       steady_clock::time_point::max() - now))
+        return steady_clock::time_point::max();
+    return now + timeout;
+}
+
+#if !defined(USE_SUSPEND_QUEUE_STATS)
+// - Note
+//      `coroutine_task_t` holds the frame's address only.
+//      Reinterpret them without copy for batch operations
+GSL_SUPPRESS(type.1)
+auto as_messages(gsl::span<coroutine_task_t> coros) noexcept
+    -> gsl::span<message_t>
+{
+    static_assert(sizeof(coroutine_task_t) == sizeof(message_t));
+    return {reinterpret_cast<message_t*>(coros.data()), coros.size()};
+}
+#endif
+
+suspend_queue::suspend_queue() noexcept(false)
+    : suspend_queue{mode::lock_cond}
+{
+}
+
+suspend_queue::suspend_queue(mode m) noexcept(false)
+    : suspend_queue{m, 0}
+{
+}
+
+suspend_queue::suspend_queue(mode m, size_t capacity) noexcept(false)
+    : storage{}
 {
     auto* self = new (get_impl(this)) suspend_queue_impl{};
-    self->mq = create_message_queue();
+    self->m = m;
+    switch (m)
+    {
+    case mode::lock_free:
+        self->mq = create_lock_free_queue();
+        break;
+    case mode::unbounded:
+        self->mq = create_segment_queue();
+        break;
+    case mode::priority:
+        self->mq = create_priority_queue();
+        break;
+    case mode::sharded:
+        self->mq = create_sharded_queue();
+        break;
+    case mode::spsc:
+        self->mq = create_spsc_queue();
+        break;
+    case mode::event:
+        self->mq = create_event_queue(self->stats);
+        break;
+    case mode::lock_cond:
+    default:
+        self->mq = capacity ? create_message_queue(capacity)
+                            : create_message_queue();
+        break;
+    }
 }
 
 suspend_queue::~suspend_queue() noexcept
@@ -37,26 +149,219 @@ suspend_queue::~suspend_queue() noexcept
     get_impl(this)->~suspend_queue_impl();
 }
 
+static_assert(suspend_queue::priority_levels == priority_levels);
+
 void suspend_queue::push(coroutine_task_t coro) noexcept(false)
 {
+    return push(coro, priority_levels / 2);
+}
+
+void suspend_queue::push(coroutine_task_t coro,
+                         uint32_t priority) noexcept(false)
+{
+    auto self = get_impl(this);
     size_t retry_count = 5000;
     message_t m{};
 
     m.ptr = coro.address();
-    while (get_impl(this)->mq->post(m) == false)
-        if (--retry_count)
+    self->stats.on_push({&m, 1});
+    while (self->mq->post_at(m, priority) == false)
+        if (self->stats.on_retry(), --retry_count)
             continue;
         else
             throw std::runtime_error{"can't push to suspend queue"};
+
+    self->notify(1);
 }
 
 bool suspend_queue::try_pop(coroutine_task_t& coro) noexcept
 {
+    auto self = get_impl(this);
     message_t m{};
-    if (get_impl(this)->mq->peek(m))
+    if (self->mq->peek(m))
     {
+        self->stats.on_pop({&m, 1});
         coro = coroutine_task_t::from_address(m.ptr);
         return true;
     }
     return false;
 }
+
+// - Note
+//      Post all messages. Retry if the queue is full
+void post_all(suspend_queue_impl& impl,
+              gsl::span<message_t> msgs) noexcept(false)
+{
+    size_t retry_count = 5000;
+    impl.stats.on_push(msgs);
+
+    while (msgs.empty() == false)
+        if (const auto count = impl.mq->post_n(msgs))
+            msgs = msgs.subspan(count);
+        else if (impl.stats.on_retry(), --retry_count)
+            continue;
+        else
+            throw std::runtime_error{"can't push to suspend queue"};
+}
+
+#if defined(USE_SUSPEND_QUEUE_STATS)
+
+// - Note
+//      Messages carry timestamps. Copy through a buffer
+static constexpr size_t batch_buffer_size = 64;
+
+void suspend_queue::push_n(gsl::span<coroutine_task_t> coros) noexcept(false)
+{
+    std::array<message_t, batch_buffer_size> buf{};
+    for (auto remain = coros; remain.empty() == false;)
+    {
+        const auto count = std::min(remain.size(), buf.size());
+        for (size_t i = 0; i < count; ++i)
+            buf[i].ptr = remain[i].address();
+
+        post_all(*get_impl(this), {buf.data(), count});
+        remain = remain.subspan(count);
+    }
+    get_impl(this)->notify(coros.size());
+}
+
+bool suspend_queue::try_pop_n(gsl::span<coroutine_task_t>& coros) noexcept
+{
+    auto self = get_impl(this);
+    std::array<message_t, batch_buffer_size> buf{};
+    size_t total = 0;
+    while (total < static_cast<size_t>(coros.size()))
+    {
+        const auto limit = std::min(coros.size() - total, buf.size());
+        const auto count = self->mq->peek_n({buf.data(), limit});
+        self->stats.on_pop({buf.data(), count});
+        for (size_t i = 0; i < count; ++i)
+            coros[total + i] = coroutine_task_t::from_address(buf[i].ptr);
+
+        total += count;
+        if (count < limit)
+            break;
+    }
+    coros = coros.first(total);
+    return total > 0;
+}
+
+#else
+
+void suspend_queue::push_n(gsl::span<coroutine_task_t> coros) noexcept(false)
+{
+    post_all(*get_impl(this), as_messages(coros));
+    get_impl(this)->notify(coros.size());
+}
+
+bool suspend_queue::try_pop_n(gsl::span<coroutine_task_t>& coros) noexcept
+{
+    const auto count = get_impl(this)->mq->peek_n(as_messages(coros));
+    coros = coros.first(count);
+    return count > 0;
+}
+
+#endif
+
+bool suspend_queue::snapshot(suspend_queue_stats& stats) const noexcept
+{
+    // counters are atomic. reading them doesn't change the queue
+    return get_impl(const_cast<suspend_queue*>(this))->stats.snapshot(stats);
+}
+
+size_t suspend_queue::resume_batch(size_t max_count,
+                                  duration max_time) noexcept(false)
+{
+    const auto until = deadline_of(max_time);
+    coroutine_task_t coro{}, next{};
+
+    // check the budget before the first pop too.
+    // zero `max_time` resumes nothing
+    size_t count = 0;
+    if (max_count == 0 || steady_clock::now() >= until ||
+        try_pop(coro) == false)
+        return count;
+
+    while (true)
+    {
+        ++count;
+        // pop the next one before the resume,
+        // so its frame can be loaded while the current one runs
+        const bool has_next = count < max_count &&
+                              steady_clock::now() < until && try_pop(next);
+        if (has_next)
+            prefetch(next.address());
+
+        try
+        {
+            coro.resume();
+        }
+        catch (...)
+        {
+            // don't lose the popped one
+            if (has_next)
+                push(next);
+            throw;
+        }
+        if (has_next == false)
+            return count;
+        coro = next;
+    }
+}
+
+bool suspend_queue::wait_pop(coroutine_task_t& coro, duration timeout) noexcept
+{
+    auto self = get_impl(this);
+
+    // spin with exponential backoff.
+    // the limit grows when spinning was worth it, and shrinks if not
+    const auto limit = self->spin_limit.load(std::memory_order_relaxed);
+    for (uint32_t backoff = 1; backoff <= limit; backoff *= 2)
+    {
+        if (try_pop(coro))
+        {
+            self->spin_limit.store(
+                std::min(limit * 2, suspend_queue_impl::max_spin),
+                std::memory_order_relaxed);
+            return true;
+        }
+        for (uint32_t i = 0; i < backoff; ++i)
+            spin_pause();
+    }
+    self->spin_limit.store(std::max(limit / 2, suspend_queue_impl::min_spin),
+                           std::memory_order_relaxed);
+
+    // park until push or timeout
+    const auto until = deadline_of(timeout);
+    while (true)
+    {
+        self->sleeping.fetch_add(1, std::memory_order_seq_cst);
+        const auto e = self->epoch.load(std::memory_order_seq_cst);
+
+        // check again. pusher may have missed the sleeper count
+        bool popped = try_pop(coro);
+        const auto now = steady_clock::now();
+        if (popped == false && now < until)
+        {
+            // `park_on` takes `duration::max()` as no timeout
+            auto remain = until == steady_clock::time_point::max()
+                              ? duration::max()
+                              : duration_cast<duration>(until - now);
+            if (self->m == mode::spsc)
+                remain = std::min(remain, suspend_queue_impl::spsc_park_slice);
+            park_on(self->epoch, e, remain);
+            popped = try_pop(coro);
+        }
+        self->sleeping.fetch_sub(1, std::memory_order_relaxed);
+
+        if (popped)
+            return true;
+        if (steady_clock::now() >= until)
+            return false;
+    }
+}
+
+bool suspend_queue::locality(uint64_t& local, uint64_t& remote) noexcept
+{
+    return get_impl(this)->mq->locality(local, remote);
+}
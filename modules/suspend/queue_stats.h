@@ -0,0 +1,125 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+//  Note
+//      Counters of `suspend_queue`.
+//      Build with `USE_SUSPEND_QUEUE_STATS` to enable them.
+//      Without the macro, every operation is empty and inlined away
+//
+// ---------------------------------------------------------------------------
+#pragma once
+#include <coroutine/suspend.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+#include "suspend/message_queue.h"
+
+#if defined(USE_SUSPEND_QUEUE_STATS)
+
+class queue_stats_t final
+{
+    static constexpr uint32_t stripe_count = 16;
+    static constexpr auto bucket_count = suspend_queue_stats::bucket_count;
+
+    // - Note
+    //      Threads are spread over the stripes,
+    //      so they rarely write to the same cache line
+    struct alignas(cache_line_size) stripe_t final
+    {
+        std::atomic<uint64_t> push{};
+        std::atomic<uint64_t> pop{};
+        std::atomic<uint64_t> retry{};
+        std::atomic<uint64_t> latency[bucket_count]{};
+    };
+
+  private:
+    std::unique_ptr<stripe_t[]> stripes =
+        std::make_unique<stripe_t[]>(stripe_count);
+
+  private:
+    static uint64_t now() noexcept
+    {
+        using namespace std::chrono;
+        const auto t = steady_clock::now().time_since_epoch();
+        return static_cast<uint64_t>(duration_cast<nanoseconds>(t).count());
+    }
+    stripe_t& local() noexcept
+    {
+        static std::atomic<uint32_t> next{};
+        thread_local const uint32_t index = next++ % stripe_count;
+        return stripes[index];
+    }
+    static uint32_t bucket_of(uint64_t ns) noexcept
+    {
+        uint32_t bucket = 0;
+        while (ns >>= 1)
+            ++bucket;
+        return bucket < bucket_count ? bucket : bucket_count - 1;
+    }
+
+  public:
+    void on_push(gsl::span<message_t> msgs) noexcept
+    {
+        const auto stamp = now();
+        for (message_t& msg : msgs)
+            msg.stamp = stamp;
+        local().push.fetch_add(msgs.size(), std::memory_order_relaxed);
+    }
+    void on_retry() noexcept
+    {
+        local().retry.fetch_add(1, std::memory_order_relaxed);
+    }
+    void on_pop(gsl::span<const message_t> msgs) noexcept
+    {
+        const auto stamp = now();
+        stripe_t& s = local();
+        for (const message_t& msg : msgs)
+        {
+            const auto bucket = bucket_of(stamp - msg.stamp);
+            s.latency[bucket].fetch_add(1, std::memory_order_relaxed);
+        }
+        s.pop.fetch_add(msgs.size(), std::memory_order_relaxed);
+    }
+
+    bool snapshot(suspend_queue_stats& stats) const noexcept
+    {
+        stats = suspend_queue_stats{};
+        for (uint32_t i = 0; i < stripe_count; ++i)
+        {
+            const stripe_t& s = stripes[i];
+            stats.push_count += s.push.load(std::memory_order_relaxed);
+            stats.pop_count += s.pop.load(std::memory_order_relaxed);
+            stats.retry_count += s.retry.load(std::memory_order_relaxed);
+            for (size_t b = 0; b < bucket_count; ++b)
+                stats.latency[b] += s.latency[b].load(std::memory_order_relaxed);
+        }
+        return true;
+    }
+};
+
+#else
+
+class queue_stats_t final
+{
+  public:
+    void on_push(gsl::span<message_t>) noexcept
+    {
+    }
+    void on_retry() noexcept
+    {
+    }
+    void on_pop(gsl::span<const message_t>) noexcept
+    {
+    }
+    bool snapshot(suspend_queue_stats& stats) const noexcept
+    {
+        stats = suspend_queue_stats{};
+        return false;
+    }
+};
+
+#endif
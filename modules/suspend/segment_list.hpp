@@ -0,0 +1,134 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+// ---------------------------------------------------------------------------
+#pragma once
+
+#include <array>
+#include <new>
+
+// - Note
+//      Unbounded FIFO queue with linked fixed-size segments.
+//      Drained segments are kept in a small pool for the next burst.
+//      Segments over the pool limit are freed so the memory shrinks back.
+//      This type is not thread-safe.
+template <typename ElemType, size_t SegmentSize = 256, size_t PoolLimit = 4>
+class segment_list_t
+{
+  public:
+    using value_type = ElemType;
+    using index_type = uint32_t;
+
+  private:
+    struct segment_t final
+    {
+        segment_t* next = nullptr;
+        index_type begin = 0;
+        index_type end = 0;
+        std::array<value_type, SegmentSize> storage{};
+    };
+
+    segment_t* head = nullptr;
+    segment_t* tail = nullptr;
+    segment_t* pool = nullptr; // recycled segments
+    size_t pool_count = 0;
+
+  private:
+    segment_t* acquire() noexcept
+    {
+        if (pool == nullptr)
+            return new (std::nothrow) segment_t{};
+
+        segment_t* seg = pool;
+        pool = seg->next;
+        --pool_count;
+
+        seg->next = nullptr;
+        seg->begin = seg->end = 0;
+        return seg;
+    }
+    void release(segment_t* seg) noexcept
+    {
+        if (pool_count == PoolLimit)
+        {
+            delete seg;
+            return;
+        }
+        seg->next = pool;
+        pool = seg;
+        ++pool_count;
+    }
+
+    static void clear(segment_t* list) noexcept
+    {
+        while (list)
+        {
+            segment_t* seg = list;
+            list = list->next;
+            delete seg;
+        }
+    }
+
+  public:
+    segment_list_t() noexcept = default;
+    segment_list_t(const segment_list_t&) = delete;
+    segment_list_t(segment_list_t&&) = delete;
+    segment_list_t& operator=(const segment_list_t&) = delete;
+    segment_list_t& operator=(segment_list_t&&) = delete;
+
+    ~segment_list_t() noexcept
+    {
+        clear(head);
+        clear(pool);
+    }
+
+  public:
+    bool empty() const noexcept
+    {
+        return head == nullptr || head->begin == head->end;
+    }
+
+    // - Note
+    //      Fails only when the allocation fails
+    bool push(const value_type& msg) noexcept
+    {
+        if (tail == nullptr || tail->end == SegmentSize)
+        {
+            segment_t* seg = acquire();
+            if (seg == nullptr)
+                return false;
+
+            if (tail)
+                tail->next = seg;
+            else
+                head = seg;
+            tail = seg;
+        }
+        tail->storage[tail->end++] = msg; // expect copy
+        return true;
+    }
+
+    [[nodiscard]] bool try_pop(value_type& msg) noexcept
+    {
+        if (empty())
+            return false;
+
+        msg = std::move(head->storage[head->begin++]); // expect move
+        if (head->begin != head->end)
+            return true;
+
+        // the segment is drained
+        if (head == tail)
+        {
+            // reuse in place. no need to touch the pool
+            head->begin = head->end = 0;
+            return true;
+        }
+        segment_t* seg = head;
+        head = head->next;
+        release(seg);
+        return true;
+    }
+};
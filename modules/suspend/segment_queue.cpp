@@ -0,0 +1,92 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+// ---------------------------------------------------------------------------
+#include <condition_variable>
+
+#include "suspend/message_queue.h"
+#include "suspend/section.h"
+#include "suspend/segment_list.hpp"
+
+using namespace std;
+
+class segment_queue_t final : public messaging_queue_t
+{
+  private:
+    section cs{};
+    condition_variable_any cv{};
+    segment_list_t<message_t> sl{};
+
+  public:
+    bool post(message_t msg) noexcept override;
+    bool peek(message_t& msg) noexcept override;
+    bool wait(message_t& msg, duration timeout) noexcept override;
+
+    size_t post_n(gsl::span<const message_t> msgs) noexcept override;
+    size_t peek_n(gsl::span<message_t> msgs) noexcept override;
+};
+
+bool segment_queue_t::post(message_t msg) noexcept
+{
+    unique_lock lck{cs};
+    if (sl.push(msg) == true)
+    {
+        cv.notify_one();
+        return true;
+    }
+    return false;
+}
+
+bool segment_queue_t::peek(message_t& msg) noexcept
+{
+    unique_lock lck{cs};
+    return sl.try_pop(msg);
+}
+
+bool segment_queue_t::wait(message_t& msg, duration timeout) noexcept
+{
+    msg = message_t{}; // zero the memory
+
+    unique_lock lck{cs};
+    if (sl.empty())
+        cv.wait_for(lck, timeout);
+
+    return sl.try_pop(msg);
+}
+
+size_t segment_queue_t::post_n(gsl::span<const message_t> msgs) noexcept
+{
+    size_t count = 0;
+    unique_lock lck{cs};
+    for (const message_t& msg : msgs)
+        if (sl.push(msg))
+            ++count;
+        else
+            break;
+
+    // notify once for the batch
+    if (count == 1)
+        cv.notify_one();
+    else if (count > 1)
+        cv.notify_all();
+    return count;
+}
+
+size_t segment_queue_t::peek_n(gsl::span<message_t> msgs) noexcept
+{
+    size_t count = 0;
+    unique_lock lck{cs};
+    for (message_t& msg : msgs)
+        if (sl.try_pop(msg))
+            ++count;
+        else
+            break;
+    return count;
+}
+
+auto create_segment_queue() noexcept(false) -> unique_ptr<messaging_queue_t>
+{
+    return make_unique<segment_queue_t>();
+}
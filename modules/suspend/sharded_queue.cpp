@@ -0,0 +1,160 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+// ---------------------------------------------------------------------------
+#include <atomic>
+#include <condition_variable>
+#include <vector>
+
+#include "suspend/cpu.h"
+#include "suspend/message_queue.h"
+#include "suspend/section.h"
+#include "suspend/segment_list.hpp"
+
+using namespace std;
+
+// - Note
+//      Each shard is used by the threads on one processor.
+//      Its members are in their own cache lines
+struct alignas(cache_line_size) shard_t final
+{
+    section cs{};
+    segment_list_t<message_t, 64> sl{};
+    // for lock-free check of neighbours
+    atomic<size_t> size{};
+
+    // counted by the consumers on this shard's processor
+    alignas(cache_line_size) atomic<uint64_t> local{};
+    atomic<uint64_t> remote{};
+};
+
+// - Note
+//      Push to the shard of current processor.
+//      Pop from the local shard first, then steal from the neighbours
+class sharded_queue_t final : public messaging_queue_t
+{
+  private:
+    vector<unique_ptr<shard_t>> shards{};
+
+    // for `wait`. the lock is used only for sleeping
+    section cs{};
+    condition_variable_any cv{};
+
+  private:
+    auto local_index() const noexcept -> size_t
+    {
+        return current_cpu() % shards.size();
+    }
+
+    static bool try_pop(shard_t& shard, message_t& msg) noexcept
+    {
+        if (shard.size.load(memory_order_acquire) == 0)
+            return false;
+
+        unique_lock lck{shard.cs};
+        if (shard.sl.try_pop(msg) == false)
+            return false;
+        shard.size.fetch_sub(1, memory_order_relaxed);
+        return true;
+    }
+
+  public:
+    sharded_queue_t() noexcept(false) : shards(cpu_count())
+    {
+        for (auto& shard : shards)
+            shard = make_unique<shard_t>();
+    }
+
+    bool post(message_t msg) noexcept override;
+    bool peek(message_t& msg) noexcept override;
+    bool wait(message_t& msg, duration timeout) noexcept override;
+
+    size_t post_n(gsl::span<const message_t> msgs) noexcept override;
+
+    bool locality(uint64_t& local, uint64_t& remote) noexcept override;
+};
+
+bool sharded_queue_t::post(message_t msg) noexcept
+{
+    shard_t& shard = *shards[local_index()];
+    {
+        unique_lock lck{shard.cs};
+        if (shard.sl.push(msg) == false)
+            return false;
+        shard.size.fetch_add(1, memory_order_release);
+    }
+    cv.notify_one();
+    return true;
+}
+
+bool sharded_queue_t::peek(message_t& msg) noexcept
+{
+    const auto local = local_index();
+    shard_t& home = *shards[local];
+    if (try_pop(home, msg))
+    {
+        home.local.fetch_add(1, memory_order_relaxed);
+        return true;
+    }
+    // nearest neighbour first. they are likely to share the cache
+    for (size_t i = 1; i < shards.size(); ++i)
+    {
+        if (try_pop(*shards[(local + i) % shards.size()], msg) == false)
+            continue;
+        home.remote.fetch_add(1, memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool sharded_queue_t::wait(message_t& msg, duration timeout) noexcept
+{
+    msg = message_t{}; // zero the memory
+    if (peek(msg))
+        return true;
+    {
+        // notification without the lock can be missed.
+        // it is bounded by the timeout
+        unique_lock lck{cs};
+        cv.wait_for(lck, timeout);
+    }
+    return peek(msg);
+}
+
+size_t sharded_queue_t::post_n(gsl::span<const message_t> msgs) noexcept
+{
+    size_t count = 0;
+    shard_t& shard = *shards[local_index()];
+    {
+        unique_lock lck{shard.cs};
+        for (const message_t& msg : msgs)
+            if (shard.sl.push(msg))
+                ++count;
+            else
+                break;
+        shard.size.fetch_add(count, memory_order_release);
+    }
+    if (count == 1)
+        cv.notify_one();
+    else if (count > 1)
+        cv.notify_all();
+    return count;
+}
+
+bool sharded_queue_t::locality(uint64_t& local, uint64_t& remote) noexcept
+{
+    local = remote = 0;
+    for (const auto& shard : shards)
+    {
+        local += shard->local.load(memory_order_relaxed);
+        remote += shard->remote.load(memory_order_relaxed);
+    }
+    return true;
+}
+
+auto create_sharded_queue() noexcept(false) -> unique_ptr<messaging_queue_t>
+{
+    return make_unique<sharded_queue_t>();
+}
@@ -0,0 +1,134 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+//  Reference
+//      Single-Producer/Single-Consumer Queue by Dmitry Vyukov
+//      http://www.1024cores.net/home/lock-free-algorithms/queues/unbounded-spsc-queue
+//
+// ---------------------------------------------------------------------------
+#include <array>
+#include <atomic>
+#include <thread>
+
+#include "suspend/message_queue.h"
+
+using namespace std;
+using namespace std::chrono;
+
+// - Note
+//      Only one thread posts and only one thread peeks.
+//      Each side owns its index and keeps a cached copy of the other's,
+//      so the shared cache line is read only when the cache looks full/empty.
+//      There is no CAS nor fence. Only acquire/release load and store
+class spsc_queue_t final : public messaging_queue_t
+{
+    static constexpr size_t capacity = 4096; // must be power of 2
+    static constexpr size_t mask = capacity - 1;
+    static_assert((capacity & mask) == 0);
+
+  private:
+    // written by consumer
+    alignas(cache_line_size) atomic<size_t> head{};
+    size_t cached_tail = 0;
+    // written by producer
+    alignas(cache_line_size) atomic<size_t> tail{};
+    size_t cached_head = 0;
+
+    alignas(cache_line_size) array<message_t, capacity> slots{};
+
+  private:
+    // - Note
+    //      Num of slots the producer can fill
+    size_t writable() noexcept
+    {
+        const auto pos = tail.load(memory_order_relaxed);
+        if (pos - cached_head == capacity)
+            cached_head = head.load(memory_order_acquire);
+        return capacity - (pos - cached_head);
+    }
+    // - Note
+    //      Num of slots the consumer can take
+    size_t readable() noexcept
+    {
+        const auto pos = head.load(memory_order_relaxed);
+        if (cached_tail == pos)
+            cached_tail = tail.load(memory_order_acquire);
+        return cached_tail - pos;
+    }
+
+  public:
+    bool post(message_t msg) noexcept override;
+    bool peek(message_t& msg) noexcept override;
+    bool wait(message_t& msg, duration timeout) noexcept override;
+
+    size_t post_n(gsl::span<const message_t> msgs) noexcept override;
+    size_t peek_n(gsl::span<message_t> msgs) noexcept override;
+};
+
+bool spsc_queue_t::post(message_t msg) noexcept
+{
+    if (writable() == 0)
+        return false;
+
+    const auto pos = tail.load(memory_order_relaxed);
+    slots[pos & mask] = msg;
+    // publish to consumer
+    tail.store(pos + 1, memory_order_release);
+    return true;
+}
+
+bool spsc_queue_t::peek(message_t& msg) noexcept
+{
+    if (readable() == 0)
+        return false;
+
+    const auto pos = head.load(memory_order_relaxed);
+    msg = slots[pos & mask];
+    // release the slot to producer
+    head.store(pos + 1, memory_order_release);
+    return true;
+}
+
+bool spsc_queue_t::wait(message_t& msg, duration timeout) noexcept
+{
+    msg = message_t{}; // zero the memory
+
+    // there is no condition variable. poll until the timeout
+    const auto until = steady_clock::now() + timeout;
+    do
+    {
+        if (peek(msg))
+            return true;
+        this_thread::yield();
+    } while (steady_clock::now() < until);
+
+    return peek(msg);
+}
+
+size_t spsc_queue_t::post_n(gsl::span<const message_t> msgs) noexcept
+{
+    const auto count = min(writable(), static_cast<size_t>(msgs.size()));
+    const auto pos = tail.load(memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i)
+        slots[(pos + i) & mask] = msgs[i];
+    // publish the batch at once
+    tail.store(pos + count, memory_order_release);
+    return count;
+}
+
+size_t spsc_queue_t::peek_n(gsl::span<message_t> msgs) noexcept
+{
+    const auto count = min(readable(), static_cast<size_t>(msgs.size()));
+    const auto pos = head.load(memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i)
+        msgs[i] = slots[(pos + i) & mask];
+    head.store(pos + count, memory_order_release);
+    return count;
+}
+
+auto create_spsc_queue() noexcept(false) -> unique_ptr<messaging_queue_t>
+{
+    return make_unique<spsc_queue_t>();
+}
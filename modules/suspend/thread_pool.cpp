@@ -0,0 +1,201 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+// ---------------------------------------------------------------------------
+#include <coroutine/suspend.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "suspend/message_queue.h"
+#include "suspend/work_stealing_deque.hpp"
+
+using namespace std;
+
+struct thread_pool_data;
+
+struct worker_t final
+{
+    thread_pool_data* pool = nullptr;
+    size_t index = 0;
+    work_stealing_deque_t<1024> deque{};
+    thread th{};
+};
+
+struct thread_pool_data final
+{
+    atomic<bool> stop{};
+    atomic<uint32_t> sleeping{}; // num of parked workers
+    atomic<uint64_t> epoch{};    // increased when parked workers must wake
+    mutex mtx{};
+    condition_variable cv{};
+
+    // coroutines from non-worker threads and overflow of the deques
+    unique_ptr<messaging_queue_t> injection = create_segment_queue();
+    vector<unique_ptr<worker_t>> workers{};
+
+  public:
+    void wake_if_parked() noexcept;
+    bool find_task(worker_t& w, coroutine_task_t& coro) noexcept;
+    void park(worker_t& w) noexcept;
+    void run(worker_t& w) noexcept;
+};
+
+// worker of the current thread. `nullptr` for non-worker threads
+thread_local worker_t* current_worker = nullptr;
+
+struct thread_pool_impl final
+{
+    unique_ptr<thread_pool_data> data{};
+};
+
+GSL_SUPPRESS(type.1)
+auto get_impl(gsl::not_null<thread_pool*> p) noexcept
+    -> gsl::not_null<thread_pool_impl*>
+{
+    static_assert(sizeof(thread_pool) >= sizeof(thread_pool_impl));
+    return reinterpret_cast<thread_pool_impl*>(p.get());
+}
+
+void thread_pool_data::wake_if_parked() noexcept
+{
+    // pushed item must be visible before checking the sleepers
+    atomic_thread_fence(memory_order_seq_cst);
+    if (sleeping.load(memory_order_relaxed) == 0)
+        return;
+
+    epoch.fetch_add(1, memory_order_seq_cst);
+    unique_lock lck{mtx};
+    cv.notify_one();
+}
+
+bool thread_pool_data::find_task(worker_t& w, coroutine_task_t& coro) noexcept
+{
+    void* ptr = nullptr;
+    message_t msg{};
+
+    if (w.deque.pop(ptr) == false)
+    {
+        if (injection->peek(msg))
+            ptr = msg.ptr;
+        else
+        {
+            // steal from siblings. start from the next one
+            const auto count = workers.size();
+            for (size_t i = 1; i < count && ptr == nullptr; ++i)
+            {
+                worker_t& victim = *workers[(w.index + i) % count];
+                if (victim.deque.steal(ptr) == false)
+                    ptr = nullptr;
+            }
+        }
+    }
+    if (ptr == nullptr)
+        return false;
+
+    coro = coroutine_task_t::from_address(ptr);
+    return true;
+}
+
+void thread_pool_data::park(worker_t& w) noexcept
+{
+    sleeping.fetch_add(1, memory_order_seq_cst);
+    const auto e = epoch.load(memory_order_seq_cst);
+
+    // scan again. pusher may have missed the sleeper count
+    coroutine_task_t coro{};
+    if (find_task(w, coro))
+    {
+        sleeping.fetch_sub(1, memory_order_relaxed);
+        coro.resume();
+        return;
+    }
+
+    unique_lock lck{mtx};
+    cv.wait(lck, [this, e]() {
+        return epoch.load(memory_order_relaxed) != e
+               || stop.load(memory_order_relaxed);
+    });
+    sleeping.fetch_sub(1, memory_order_relaxed);
+}
+
+void thread_pool_data::run(worker_t& w) noexcept
+{
+    current_worker = addressof(w);
+
+    coroutine_task_t coro{};
+    while (true)
+    {
+        if (find_task(w, coro))
+        {
+            coro.resume();
+            continue;
+        }
+        // all works are done before the exit
+        if (stop.load(memory_order_acquire))
+            break;
+
+        park(w);
+    }
+    current_worker = nullptr;
+}
+
+thread_pool::thread_pool(uint32_t count) noexcept(false) : storage{}
+{
+    auto* self = new (get_impl(this)) thread_pool_impl{};
+    self->data = make_unique<thread_pool_data>();
+    auto& pool = *self->data;
+
+    if (count == 0)
+        count = max(thread::hardware_concurrency(), 1u);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto w = make_unique<worker_t>();
+        w->pool = addressof(pool);
+        w->index = i;
+        pool.workers.emplace_back(move(w));
+    }
+    // start after all workers are ready for stealing
+    for (auto& w : pool.workers)
+        w->th = thread{&thread_pool_data::run, addressof(pool), ref(*w)};
+}
+
+thread_pool::~thread_pool() noexcept
+{
+    auto self = get_impl(this);
+    auto& pool = *self->data;
+    {
+        unique_lock lck{pool.mtx};
+        pool.stop.store(true, memory_order_release);
+        pool.epoch.fetch_add(1, memory_order_seq_cst);
+        pool.cv.notify_all();
+    }
+    for (auto& w : pool.workers)
+        if (w->th.joinable())
+            w->th.join();
+
+    self->~thread_pool_impl();
+}
+
+void thread_pool::push(coroutine_task_t coro) noexcept(false)
+{
+    auto& pool = *get_impl(this)->data;
+
+    // worker of this pool. use its own deque without contention
+    worker_t* w = current_worker;
+    if (w == nullptr || w->pool != addressof(pool)
+        || w->deque.push(coro.address()) == false)
+    {
+        message_t msg{};
+        msg.ptr = coro.address();
+        if (pool.injection->post(msg) == false)
+            throw runtime_error{"can't push to thread pool"};
+    }
+    pool.wake_if_parked();
+}
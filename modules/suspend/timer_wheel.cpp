@@ -0,0 +1,363 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+//  Reference
+//      Hashed and Hierarchical Timing Wheels (Varghese & Lauck)
+//      http://www.cs.columbia.edu/~nahum/w6998/papers/sosp87-timing-wheels.pdf
+//
+// ---------------------------------------------------------------------------
+#include <coroutine/suspend.h>
+
+#include <array>
+#include <mutex>
+
+#include "suspend/section.h"
+
+using namespace std;
+using namespace std::chrono;
+
+// - Note
+//      6 levels of 64 slots. Level `L` slot covers 64^L ticks,
+//      so the wheel covers 2^36 ms (about 2 years) without overflow
+struct timer_wheel_impl final
+{
+    static constexpr uint32_t bits = 6;
+    static constexpr uint32_t slot_count = 1u << bits;
+    static constexpr uint32_t level_count = 6;
+    static constexpr uint64_t mask = slot_count - 1;
+    static constexpr uint64_t max_delta = (1ull << (bits * level_count)) - 1;
+
+    using time_point = timer_wheel::time_point;
+
+  private:
+    section cs{};
+    const time_point origin = timer_wheel::clock_type::now();
+    uint64_t current = 0; // tick which is already processed
+    size_t count = 0;     // num of nodes in the slots
+    // sentinels of circular lists
+    array<array<timer_node, slot_count>, level_count> slots{};
+    timer_node ready{}; // expired but not delivered
+
+  private:
+    static void init(timer_node& sentinel) noexcept
+    {
+        sentinel.prev = sentinel.next = addressof(sentinel);
+    }
+    static void link(timer_node& sentinel, timer_node& node) noexcept
+    {
+        // push back to the list
+        node.prev = sentinel.prev;
+        node.next = addressof(sentinel);
+        sentinel.prev->next = addressof(node);
+        sentinel.prev = addressof(node);
+    }
+    static void unlink(timer_node& node) noexcept
+    {
+        node.prev->next = node.next;
+        node.next->prev = node.prev;
+        node.prev = node.next = nullptr;
+    }
+
+    // - Note
+    //      Tick of a deadline.
+    //      Round up not to expire earlier than the time point
+    uint64_t to_tick(time_point tp) const noexcept
+    {
+        if (tp <= origin)
+            return 0;
+        return static_cast<uint64_t>(ceil<milliseconds>(tp - origin).count());
+    }
+    // - Note
+    //      Last tick which is fully elapsed.
+    //      Round down, so tick `D` is reached after `origin + D` ms
+    uint64_t elapsed_tick() const noexcept
+    {
+        const auto now = timer_wheel::clock_type::now();
+        if (now <= origin)
+            return 0;
+        return static_cast<uint64_t>(
+            duration_cast<milliseconds>(now - origin).count());
+    }
+
+    // - Note
+    //      Place the node by the highest 6-bit group which differs
+    //      from the current tick
+    void place(timer_node& node) noexcept
+    {
+        const auto diff = node.deadline ^ current;
+        uint32_t level = 0;
+        while (level + 1 < level_count && (diff >> (bits * (level + 1))))
+            ++level;
+
+        const auto index = (node.deadline >> (bits * level)) & mask;
+        link(slots[level][index], node);
+    }
+
+    // - Note
+    //      Move nodes in the slot to lower levels
+    void cascade(uint32_t level) noexcept
+    {
+        auto& sentinel = slots[level][(current >> (bits * level)) & mask];
+        while (sentinel.next != addressof(sentinel))
+        {
+            timer_node& node = *sentinel.next;
+            unlink(node);
+            place(node);
+        }
+    }
+
+    // - Note
+    //      The first tick after `current` which expires the nodes in level 0
+    //      or cascades an occupied slot. Nothing happens in the ticks between,
+    //      so `advance` can jump over them
+    uint64_t next_event() const noexcept
+    {
+        for (uint32_t level = 0; level < level_count; ++level)
+        {
+            const auto shift = bits * level;
+            for (auto index = ((current >> shift) & mask) + 1;
+                 index < slot_count; ++index)
+            {
+                const auto& sentinel = slots[level][index];
+                if (sentinel.next == addressof(sentinel))
+                    continue;
+                // upper digits of the current tick. lower digits are 0
+                const auto width = shift + bits;
+                return ((current >> width) << width) | (index << shift);
+            }
+        }
+        // the nodes in the highest level can wrap around.
+        // cascade at its next slot
+        const auto shift = bits * (level_count - 1);
+        return ((current >> shift) + 1) << shift;
+    }
+
+    void advance() noexcept
+    {
+        const auto now = elapsed_tick();
+        if (count == 0)
+        {
+            // nothing to expire. jump to the tick
+            current = max(current, now);
+            return;
+        }
+        while (current < now)
+        {
+            const auto tick = next_event();
+            if (tick > now)
+            {
+                // no expiry nor cascade until now
+                current = now;
+                return;
+            }
+            current = tick;
+            // cascade from the highest level whose lower digits are all 0
+            for (uint32_t level = level_count - 1; level > 0; --level)
+                if ((current & ((1ull << (bits * level)) - 1)) == 0)
+                    cascade(level);
+
+            auto& sentinel = slots[0][current & mask];
+            while (sentinel.next != addressof(sentinel))
+            {
+                timer_node& node = *sentinel.next;
+                unlink(node);
+                link(ready, node);
+                --count;
+            }
+        }
+    }
+
+    // - Note
+    //      Take the first expired node. The node is unlinked
+    auto take() noexcept -> timer_node*
+    {
+        if (ready.next == addressof(ready))
+            return nullptr;
+        timer_node* node = ready.next;
+        unlink(*node);
+        return node;
+    }
+
+  public:
+    timer_wheel_impl() noexcept
+    {
+        for (auto& level : slots)
+            for (auto& sentinel : level)
+                init(sentinel);
+        init(ready);
+    }
+
+    void insert(timer_node& node, time_point until, void* frame) noexcept
+    {
+        unique_lock lck{cs};
+        advance();
+
+        node.frame = frame;
+        // at least, next tick. and limit for the highest level
+        node.deadline = min(max(to_tick(until), current + 1),
+                            current + max_delta);
+        place(node);
+        ++count;
+    }
+
+    bool cancel(timer_node& node) noexcept
+    {
+        unique_lock lck{cs};
+        if (node.next == nullptr)
+            return false;
+
+        // the node can be in `ready` list
+        if (node.deadline > current)
+            --count;
+        unlink(node);
+        return true;
+    }
+
+    // - Note
+    //      Collect expired nodes with a lock,
+    //      then deliver them without the lock
+    template <typename Fn>
+    size_t expire(size_t limit, Fn&& deliver) noexcept(false)
+    {
+        timer_node* list = nullptr;
+        size_t n = 0;
+        {
+            unique_lock lck{cs};
+            advance();
+            for (; n < limit; ++n)
+            {
+                timer_node* node = take();
+                if (node == nullptr)
+                    break;
+                node->prev = list; // reuse as singly linked list
+                list = node;
+            }
+        }
+        // reverse order of expiry. deliver from the tail
+        timer_node* head = nullptr;
+        while (list)
+        {
+            timer_node* node = list;
+            list = list->prev;
+            node->prev = head;
+            head = node;
+        }
+        while (head)
+        {
+            // frame can be destroyed after delivery. read before it
+            timer_node* node = head;
+            head = head->prev;
+            void* frame = node->frame;
+            node->prev = nullptr;
+            try
+            {
+                deliver(coroutine_task_t::from_address(frame));
+            }
+            catch (...)
+            {
+                // don't lose the ones which are not delivered
+                node->prev = head;
+                restore(node);
+                throw;
+            }
+        }
+        return n;
+    }
+
+    // - Note
+    //      Put the nodes back to the front of `ready` in the order.
+    //      Then the next `expire` delivers them, and `cancel` can find them
+    void restore(timer_node* head) noexcept
+    {
+        unique_lock lck{cs};
+        timer_node* pos = addressof(ready);
+        while (head)
+        {
+            timer_node& node = *head;
+            head = head->prev;
+            node.prev = pos;
+            node.next = pos->next;
+            pos->next->prev = addressof(node);
+            pos->next = addressof(node);
+            pos = addressof(node);
+        }
+    }
+
+    auto next_timeout() noexcept -> timer_wheel::duration
+    {
+        unique_lock lck{cs};
+        advance();
+        if (ready.next != addressof(ready))
+            return timer_wheel::duration{0};
+        if (count == 0)
+            return timer_wheel::duration::max();
+
+        // wake up at the next expiry or cascade
+        const auto now = timer_wheel::clock_type::now();
+        const auto tick = next_event();
+        const auto until = origin + milliseconds{tick};
+        if (until <= now)
+            return timer_wheel::duration{0};
+        return duration_cast<timer_wheel::duration>(until - now);
+    }
+};
+
+struct timer_wheel_holder final
+{
+    unique_ptr<timer_wheel_impl> impl{};
+};
+
+GSL_SUPPRESS(type.1)
+auto get_impl(gsl::not_null<timer_wheel*> p) noexcept
+    -> gsl::not_null<timer_wheel_impl*>
+{
+    static_assert(sizeof(timer_wheel) >= sizeof(timer_wheel_holder));
+    return reinterpret_cast<timer_wheel_holder*>(p.get())->impl.get();
+}
+
+timer_wheel::timer_wheel() noexcept(false) : storage{}
+{
+    auto* holder = new (const_cast<uint64_t*>(storage)) timer_wheel_holder{};
+    holder->impl = make_unique<timer_wheel_impl>();
+}
+
+timer_wheel::~timer_wheel() noexcept
+{
+    auto* holder = reinterpret_cast<timer_wheel_holder*>(this);
+    holder->~timer_wheel_holder();
+}
+
+void timer_wheel::insert(timer_node& node, time_point until,
+                         coroutine_task_t coro) noexcept
+{
+    get_impl(this)->insert(node, until, coro.address());
+}
+
+bool timer_wheel::cancel(timer_node& node) noexcept
+{
+    return get_impl(this)->cancel(node);
+}
+
+size_t timer_wheel::expire(suspend_queue& sq) noexcept(false)
+{
+    return get_impl(this)->expire(SIZE_MAX, [&sq](coroutine_task_t coro) {
+        sq.push(coro); //
+    });
+}
+
+bool timer_wheel::expire(gsl::span<coroutine_task_t>& coros) noexcept
+{
+    size_t i = 0;
+    get_impl(this)->expire(coros.size(), [&coros, &i](coroutine_task_t coro) {
+        coros[i++] = coro; //
+    });
+    coros = coros.first(i);
+    return i > 0;
+}
+
+auto timer_wheel::next_timeout() noexcept -> duration
+{
+    return get_impl(this)->next_timeout();
+}
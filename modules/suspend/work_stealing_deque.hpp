@@ -0,0 +1,102 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+//  Reference
+//      Correct and Efficient Work-Stealing for Weak Memory Models
+//      https://www.di.ens.fr/~zappa/readings/ppopp13.pdf
+//
+// ---------------------------------------------------------------------------
+#pragma once
+
+#include <array>
+#include <atomic>
+
+#include "suspend/message_queue.h"
+
+// - Note
+//      Chase-Lev deque with fixed capacity.
+//      Only the owner thread can `push` and `pop` at the bottom.
+//      Other threads `steal` from the top.
+//      `push` fails when the deque is full. Caller must handle the overflow.
+//      `pop` and `steal` change the output only when they succeed
+template <size_t Capacity>
+class work_stealing_deque_t
+{
+    static constexpr size_t mask = Capacity - 1;
+    static_assert((Capacity & mask) == 0, "Capacity must be power of 2");
+
+  public:
+    using value_type = void*;
+
+  private:
+    alignas(cache_line_size) std::atomic<int64_t> top{};    // steal end
+    alignas(cache_line_size) std::atomic<int64_t> bottom{}; // owner end
+    alignas(cache_line_size) std::array<std::atomic<value_type>, Capacity>
+        buffer{};
+
+  public:
+    bool push(value_type v) noexcept
+    {
+        using namespace std;
+        const int64_t b = bottom.load(memory_order_relaxed);
+        const int64_t t = top.load(memory_order_acquire);
+        if (b - t >= static_cast<int64_t>(Capacity))
+            return false;
+
+        buffer[b & mask].store(v, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        bottom.store(b + 1, memory_order_relaxed);
+        return true;
+    }
+
+    bool pop(value_type& v) noexcept
+    {
+        using namespace std;
+        const int64_t b = bottom.load(memory_order_relaxed) - 1;
+        bottom.store(b, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        int64_t t = top.load(memory_order_relaxed);
+
+        if (t > b) // empty
+        {
+            bottom.store(b + 1, memory_order_relaxed);
+            return false;
+        }
+
+        const auto item = buffer[b & mask].load(memory_order_relaxed);
+        if (t < b) // more than 1. no race with thieves
+        {
+            v = item;
+            return true;
+        }
+
+        // the last one. compete with thieves.
+        // `v` is not changed if a thief took it
+        const bool won = top.compare_exchange_strong(
+            t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+        bottom.store(b + 1, memory_order_relaxed);
+        if (won)
+            v = item;
+        return won;
+    }
+
+    bool steal(value_type& v) noexcept
+    {
+        using namespace std;
+        int64_t t = top.load(memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        const int64_t b = bottom.load(memory_order_acquire);
+
+        if (t >= b) // empty
+            return false;
+
+        const auto item = buffer[t & mask].load(memory_order_relaxed);
+        if (top.compare_exchange_strong(t, t + 1, memory_order_seq_cst,
+                                        memory_order_relaxed) == false)
+            return false; // the owner or another thief took it
+        v = item;
+        return true;
+    }
+};
@@ -0,0 +1,28 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+// ---------------------------------------------------------------------------
+#include <coroutine/suspend.h>
+
+#include "suspend/cpu.h"
+
+#include <Windows.h>
+
+uint32_t current_cpu() noexcept
+{
+    return GetCurrentProcessorNumber();
+}
+
+bool pin_current_thread(uint32_t cpu) noexcept
+{
+    // - Note
+    //      Processor groups are not considered.
+    //      The index must be in the current group
+    if (cpu >= sizeof(DWORD_PTR) * 8)
+        return false;
+
+    const DWORD_PTR mask = DWORD_PTR{1} << cpu;
+    return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+}
@@ -6,6 +6,8 @@
 // ---------------------------------------------------------------------------
 #include <coroutine/net.h>
 
+#include "suspend/message_queue.h"
+
 auto wait_io_tasks(std::chrono::nanoseconds) noexcept(false)
     -> enumerable<coroutine_task_t>
 {
@@ -14,6 +16,15 @@ auto wait_io_tasks(std::chrono::nanoseconds) noexcept(false)
     co_return;
 }
 
+auto create_event_queue(queue_stats_t&) noexcept(false)
+    -> std::unique_ptr<messaging_queue_t>
+{
+    // there is no I/O loop to wake up. see `wait_io_tasks`
+    throw std::system_error{
+        std::make_error_code(std::errc::function_not_supported),
+        "event queue requires Linux eventfd"};
+}
+
 GSL_SUPPRESS(type .1)
 GSL_SUPPRESS(f .6)
 void CALLBACK onWorkDone(DWORD errc, DWORD sz, LPWSAOVERLAPPED pover,
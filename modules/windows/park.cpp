@@ -0,0 +1,38 @@
+// ---------------------------------------------------------------------------
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//  Reference
+//      https://docs.microsoft.com/en-us/windows/desktop/api/synchapi/nf-synchapi-waitonaddress
+//
+// ---------------------------------------------------------------------------
+#include "suspend/park.h"
+
+#include <Windows.h>
+#pragma comment(lib, "Synchronization.lib")
+
+using namespace std;
+using namespace std::chrono;
+
+void park_on(atomic<uint32_t>& word, uint32_t expected,
+             microseconds timeout) noexcept
+{
+    static_assert(sizeof(atomic<uint32_t>) == sizeof(uint32_t));
+
+    DWORD ms = INFINITE;
+    if (timeout != microseconds::max())
+        // round up. WaitOnAddress can't handle sub-millisecond
+        ms = static_cast<DWORD>(ceil<milliseconds>(timeout).count());
+
+    WaitOnAddress(addressof(word), addressof(expected), sizeof(uint32_t), ms);
+}
+
+void unpark_one(atomic<uint32_t>& word) noexcept
+{
+    WakeByAddressSingle(addressof(word));
+}
+
+void unpark_all(atomic<uint32_t>& word) noexcept
+{
+    WakeByAddressAll(addressof(word));
+}
@@ -0,0 +1,132 @@
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+#include <catch2/catch.hpp>
+
+#include "./channel_test.h"
+
+using namespace std;
+
+template <size_t N>
+using broadcast_type = broadcast_channel<uint64_t, N, bypass_lock>;
+
+template <size_t N>
+auto write_once(broadcast_type<N>& ch, uint64_t value, bool& ok)
+    -> return_ignore
+{
+    ok = co_await ch.write(value);
+}
+
+template <size_t N>
+auto read_once(subscriber<uint64_t, N, bypass_lock>& sub,
+               const uint64_t*& msg) -> return_ignore
+{
+    msg = co_await sub.read();
+}
+
+TEST_CASE("broadcast channel", "[generic][channel]")
+{
+    bool ok = false;
+    const uint64_t *m1 = nullptr, *m2 = nullptr;
+
+    SECTION("all subscribers share the message")
+    {
+        broadcast_type<2> ch{};
+        subscriber s1{ch}, s2{ch};
+
+        read_once(s1, m1); // suspends
+        write_once(ch, 7, ok);
+        REQUIRE(ok);
+        read_once(s2, m2);
+
+        REQUIRE(m1 != nullptr);
+        REQUIRE(m1 == m2); // by reference
+        REQUIRE(*m1 == 7);
+    }
+
+    SECTION("write without subscriber")
+    {
+        broadcast_type<1> ch{};
+        for (uint64_t i = 0; i < 3; ++i)
+        {
+            ok = false;
+            write_once(ch, i, ok);
+            REQUIRE(ok);
+        }
+    }
+
+    SECTION("block until the slow subscriber releases")
+    {
+        broadcast_type<1> ch{};
+        subscriber fast{ch}, slow{ch};
+
+        write_once(ch, 1, ok);
+        REQUIRE(ok);
+        read_once(fast, m1);
+        read_once(slow, m2);
+        REQUIRE(*m2 == 1);
+
+        ok = false;
+        write_once(ch, 2, ok);
+        REQUIRE_FALSE(ok); // the slot is in use
+
+        m1 = nullptr;
+        read_once(fast, m1); // releases 1, but `slow` holds it
+        REQUIRE_FALSE(ok);
+        REQUIRE(m1 == nullptr);
+
+        slow.release(); // the writer and `fast` are resumed
+        REQUIRE(ok);
+        REQUIRE(m1 != nullptr);
+        REQUIRE(*m1 == 2);
+        read_once(slow, m2);
+        REQUIRE(*m2 == 2);
+        REQUIRE(slow.dropped() == 0);
+    }
+
+    SECTION("drop the oldest for the slow subscriber")
+    {
+        broadcast_type<2> ch{broadcast_policy::drop_oldest};
+        subscriber fast{ch}, slow{ch};
+
+        for (uint64_t i = 1; i <= 3; ++i)
+        {
+            ok = false;
+            write_once(ch, i, ok);
+            REQUIRE(ok); // never blocks
+            read_once(fast, m1);
+            REQUIRE(*m1 == i);
+        }
+        read_once(slow, m2);
+        REQUIRE(*m2 == 2);
+        REQUIRE(slow.dropped() == 1);
+        REQUIRE(fast.dropped() == 0);
+    }
+
+    SECTION("close")
+    {
+        broadcast_type<2> ch{};
+        subscriber s1{ch}, s2{ch};
+
+        const uint64_t sentinel = 0;
+        write_once(ch, 3, ok);
+        read_once(s2, m2);
+        m2 = &sentinel;
+        read_once(s2, m2); // suspends after the message
+        REQUIRE(m2 == &sentinel);
+
+        ch.close();
+        REQUIRE(m2 == nullptr);
+
+        // remaining messages can be read
+        read_once(s1, m1);
+        REQUIRE(*m1 == 3);
+        read_once(s1, m1);
+        REQUIRE(m1 == nullptr);
+
+        ok = true;
+        write_once(ch, 4, ok);
+        REQUIRE_FALSE(ok);
+    }
+}
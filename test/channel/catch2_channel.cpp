@@ -4,7 +4,16 @@
 //
 #include <catch2/catch.hpp>
 
+#include <coroutine/suspend.h>
+
+#include <atomic>
+#include <cstdio>
+#include <vector>
+
 #include "./channel_test.h"
+#include "stop_watch.hpp"
+
+using frame_t = std::experimental::coroutine_handle<void>;
 
 void test_require_true(bool cond)
 {
@@ -85,3 +94,690 @@ TEST_CASE("channel with mutex", "[generic][channel]")
         }
     }
 }
+
+TEST_CASE("channel close", "[generic][channel]")
+{
+    using namespace std;
+    using channel_type = channel<uint64_t, mutex>;
+
+    auto read_once = [](channel_type& ch, bool& ok) -> return_ignore {
+        uint64_t value{};
+        tie(value, ok) = co_await ch.read();
+    };
+    auto write_once = [](channel_type& ch, uint64_t value,
+                         bool& ok) -> return_ignore {
+        ok = co_await ch.write(value);
+    };
+
+    channel_type ch{};
+    bool ok1 = true, ok2 = true;
+
+    SECTION("resume the waiters")
+    {
+        read_once(ch, ok1);
+        read_once(ch, ok2);
+        ch.close();
+        REQUIRE_FALSE(ok1);
+        REQUIRE_FALSE(ok2);
+    }
+
+    SECTION("complete after close")
+    {
+        ch.close();
+        ch.close(); // nothing happens
+        read_once(ch, ok1);
+        write_once(ch, 1, ok2);
+        REQUIRE_FALSE(ok1);
+        REQUIRE_FALSE(ok2);
+    }
+
+    SECTION("select on closed channel")
+    {
+        channel_type other{};
+        uint64_t v1 = 0, v2 = 0;
+        ch.close();
+
+        auto [index, ok] = try_select(on_read(other, v1), on_read(ch, v2));
+        REQUIRE(index == 1);
+        REQUIRE_FALSE(ok);
+    }
+}
+
+TEST_CASE("channel resume on executor", "[generic][channel]")
+{
+    using namespace std;
+    using channel_type =
+        channel<uint64_t, bypass_lock, resume_on<suspend_queue>>;
+
+    suspend_queue sq{suspend_queue::mode::unbounded};
+    channel_type ch{resume_on{sq}};
+    uint64_t storage = 0;
+    frame_t coro{};
+
+    SECTION("writer posts the reader")
+    {
+        read_from(ch, storage);
+        write_to(ch, uint64_t{3}); // completes without resuming the reader
+
+        // the value is moved before the reader resumes
+        REQUIRE(storage == 0);
+        REQUIRE(sq.try_pop(coro));
+        coro.resume();
+        REQUIRE(storage == 3);
+        REQUIRE_FALSE(sq.try_pop(coro));
+    }
+
+    SECTION("reader posts the writer")
+    {
+        write_to(ch, uint64_t{5});
+        read_from(ch, storage);
+        REQUIRE(storage == 5);
+
+        REQUIRE(sq.try_pop(coro));
+        coro.resume(); // the writer returns
+        REQUIRE_FALSE(sq.try_pop(coro));
+    }
+
+    SECTION("long pipeline doesn't nest the resumes")
+    {
+        constexpr size_t num_stage = 1'000;
+        vector<unique_ptr<channel_type>> links{};
+        for (size_t i = 0; i <= num_stage; ++i)
+            links.emplace_back(make_unique<channel_type>(resume_on{sq}));
+
+        auto relay = [](channel_type& in, channel_type& out) -> return_ignore {
+            while (true)
+            {
+                auto [value, ok] = co_await in.read();
+                if (ok == false)
+                    co_return;
+                if (co_await out.write(value) == false)
+                    co_return;
+            }
+        };
+        for (size_t i = 0; i < num_stage; ++i)
+            relay(*links[i], *links[i + 1]);
+
+        read_from(*links.back(), storage);
+        write_to(*links.front(), uint64_t{7});
+
+        // each stage runs from the queue, not in the caller's stack
+        size_t count = 0;
+        while (sq.try_pop(coro))
+        {
+            coro.resume();
+            ++count;
+        }
+        REQUIRE(storage == 7);
+        REQUIRE(count >= num_stage);
+
+        for (auto& link : links)
+            link->close();
+        while (sq.try_pop(coro))
+            coro.resume();
+    }
+}
+
+TEST_CASE("channel try read/write", "[generic][channel]")
+{
+    using namespace std;
+    using channel_type = channel<uint64_t, bypass_lock>;
+
+    channel_type ch{};
+    uint64_t value = 5, storage = 0;
+
+    SECTION("no partner")
+    {
+        REQUIRE_FALSE(ch.try_read().has_value());
+        REQUIRE_FALSE(ch.try_write(value));
+
+        // the lock is released. normal operation works
+        read_from(ch, storage);
+        write_to(ch, uint64_t{3});
+        REQUIRE(storage == 3);
+    }
+
+    SECTION("try read from waiting writer")
+    {
+        write_to(ch, value);
+        auto result = ch.try_read();
+        REQUIRE(result.has_value());
+        REQUIRE(result.value() == 5);
+        REQUIRE_FALSE(ch.try_read().has_value());
+    }
+
+    SECTION("try write to waiting reader")
+    {
+        read_from(ch, storage);
+        REQUIRE(ch.try_write(value));
+        REQUIRE(storage == 5);
+        REQUIRE_FALSE(ch.try_write(value));
+    }
+
+    SECTION("closed")
+    {
+        ch.close();
+        REQUIRE_FALSE(ch.try_read().has_value());
+        REQUIRE_FALSE(ch.try_write(value));
+    }
+}
+
+// - Note
+//      Wait until the wheel gives an expired coroutine.
+//      `nullptr` handle if nothing expired in 5 seconds
+auto fetch_expired(timer_wheel& wheel) -> coroutine_task_t
+{
+    using namespace std;
+    const auto until = timer_wheel::clock_type::now() + 5s;
+    array<coroutine_task_t, 1> buf{};
+    while (timer_wheel::clock_type::now() < until)
+    {
+        gsl::span<coroutine_task_t> coros{buf};
+        if (wheel.expire(coros))
+            return coros[0];
+        this_thread::sleep_for(1ms);
+    }
+    return nullptr;
+}
+
+TEST_CASE("channel read/write with timeout", "[generic][channel]")
+{
+    using namespace std;
+    using channel_type = channel<uint64_t, bypass_lock>;
+
+    channel_type ch{};
+    timer_wheel wheel{};
+    uint64_t value = 5, storage = 0;
+    auto status = channel_status::success;
+
+    auto read_for = [](channel_type& ch, timer_wheel& wheel,
+                       timer_wheel::duration d, uint64_t& storage,
+                       channel_status& status) -> return_ignore {
+        tie(storage, status) = co_await ch.read_for(d, wheel);
+    };
+    auto write_for = [](channel_type& ch, timer_wheel& wheel,
+                        timer_wheel::duration d, uint64_t& value,
+                        channel_status& status) -> return_ignore {
+        status = co_await ch.write_for(value, d, wheel);
+    };
+
+    SECTION("ready without suspension")
+    {
+        write_to(ch, value);
+        read_for(ch, wheel, 1min, storage, status);
+        REQUIRE(status == channel_status::success);
+        REQUIRE(storage == 5);
+    }
+
+    SECTION("read expires")
+    {
+        status = channel_status::success;
+        read_for(ch, wheel, 1ms, storage, status);
+
+        auto coro = fetch_expired(wheel);
+        REQUIRE(coro);
+        coro.resume();
+        REQUIRE(status == channel_status::timeout);
+
+        // withdrawn from the channel
+        REQUIRE_FALSE(ch.try_write(value));
+    }
+
+    SECTION("write expires")
+    {
+        write_for(ch, wheel, 1ms, value, status);
+
+        auto coro = fetch_expired(wheel);
+        REQUIRE(coro);
+        coro.resume();
+        REQUIRE(status == channel_status::timeout);
+        REQUIRE_FALSE(ch.try_read().has_value());
+    }
+
+    SECTION("partner cancels the timer")
+    {
+        status = channel_status::timeout;
+        read_for(ch, wheel, 1min, storage, status);
+        write_to(ch, value);
+        REQUIRE(status == channel_status::success);
+        REQUIRE(storage == 5);
+        REQUIRE(wheel.next_timeout() == timer_wheel::duration::max());
+    }
+
+    SECTION("partner comes after the expiry")
+    {
+        status = channel_status::timeout;
+        read_for(ch, wheel, 1ms, storage, status);
+        auto coro = fetch_expired(wheel);
+        REQUIRE(coro);
+
+        // the value is moved, but the timer resumes the reader
+        REQUIRE(ch.try_write(value));
+        REQUIRE(status == channel_status::timeout);
+        coro.resume();
+        REQUIRE(status == channel_status::success);
+        REQUIRE(storage == 5);
+    }
+
+    SECTION("destroy while suspended")
+    {
+        auto read_frame = [](channel_type& ch, timer_wheel& wheel,
+                             channel_status& status) -> return_frame {
+            uint64_t storage = 0;
+            tie(storage, status) = co_await ch.read_for(1ms, wheel);
+        };
+        status = channel_status::success;
+        frame_t frame = read_frame(ch, wheel, status);
+        frame.destroy();
+
+        // withdrawn from the channel and the wheel
+        REQUIRE(wheel.next_timeout() == timer_wheel::duration::max());
+        this_thread::sleep_for(5ms);
+        array<coroutine_task_t, 1> buf{};
+        gsl::span<coroutine_task_t> coros{buf};
+        REQUIRE_FALSE(wheel.expire(coros));
+        REQUIRE_FALSE(ch.try_write(value));
+        REQUIRE(status == channel_status::success);
+    }
+
+    SECTION("closed")
+    {
+        read_for(ch, wheel, 1min, storage, status);
+        ch.close();
+        REQUIRE(status == channel_status::closed);
+
+        write_for(ch, wheel, 1min, value, status);
+        REQUIRE(status == channel_status::closed);
+    }
+}
+
+// - Note
+//      Count the moves of the message
+struct move_counter
+{
+    size_t moves = 0;
+    uint64_t payload = 0;
+
+    move_counter() noexcept = default;
+    explicit move_counter(uint64_t v) noexcept : payload{v}
+    {
+    }
+    move_counter(const move_counter&) = delete;
+    move_counter& operator=(const move_counter&) = delete;
+    move_counter(move_counter&& rhs) noexcept
+        : moves{rhs.moves + 1}, payload{rhs.payload}
+    {
+    }
+    move_counter& operator=(move_counter&& rhs) noexcept
+    {
+        moves = rhs.moves + 1;
+        payload = rhs.payload;
+        return *this;
+    }
+};
+
+TEST_CASE("channel move-only value", "[generic][channel]")
+{
+    using namespace std;
+
+    SECTION("write temporary and read into")
+    {
+        channel<unique_ptr<int>, bypass_lock> ch{};
+        unique_ptr<int> storage{};
+        bool ok = false;
+
+        auto write_ptr = [](decltype(ch)& ch, int v) -> return_ignore {
+            co_await ch.write(make_unique<int>(v));
+        };
+        auto read_ptr = [](decltype(ch)& ch, unique_ptr<int>& dst,
+                           bool& ok) -> return_ignore {
+            ok = co_await ch.read_into(dst);
+        };
+        read_ptr(ch, storage, ok);
+        write_ptr(ch, 3);
+        REQUIRE(ok);
+        REQUIRE(storage);
+        REQUIRE(*storage == 3);
+    }
+
+    SECTION("emplace and read into moves once")
+    {
+        channel<move_counter, bypass_lock> ch{};
+        move_counter storage{};
+        bool ok = false;
+
+        auto emplace_one = [](decltype(ch)& ch, uint64_t v) -> return_ignore {
+            co_await ch.emplace(v);
+        };
+        auto read_one = [](decltype(ch)& ch, move_counter& dst,
+                           bool& ok) -> return_ignore {
+            ok = co_await ch.read_into(dst);
+        };
+        // writer waits
+        emplace_one(ch, 7);
+        read_one(ch, storage, ok);
+        REQUIRE(ok);
+        REQUIRE(storage.payload == 7);
+        REQUIRE(storage.moves == 1);
+
+        // reader waits
+        read_one(ch, storage, ok);
+        emplace_one(ch, 9);
+        REQUIRE(storage.payload == 9);
+        REQUIRE(storage.moves == 1);
+    }
+
+    SECTION("read into closed channel")
+    {
+        channel<unique_ptr<int>, bypass_lock> ch{};
+        unique_ptr<int> storage{};
+        ch.close();
+
+        auto read_ptr = [](decltype(ch)& ch, unique_ptr<int>& dst,
+                           bool& ok) -> return_ignore {
+            ok = co_await ch.read_into(dst);
+        };
+        bool ok = true;
+        read_ptr(ch, storage, ok);
+        REQUIRE_FALSE(ok);
+    }
+}
+
+TEST_CASE("channel batch", "[generic][channel]")
+{
+    using namespace std;
+    using channel_type = channel<uint64_t, bypass_lock>;
+
+    auto write_batch = [](channel_type& ch, gsl::span<uint64_t> values,
+                          size_t& count) -> return_ignore {
+        count = co_await ch.write_n(values);
+    };
+    auto read_batch = [](channel_type& ch, gsl::span<uint64_t> values,
+                         size_t& count) -> return_ignore {
+        count = co_await ch.read_n(values);
+    };
+
+    channel_type ch{};
+    array<uint64_t, 5> values{1, 2, 3, 4, 5};
+    array<uint64_t, 8> storage{};
+    size_t count = 0;
+
+    SECTION("write to waiting readers")
+    {
+        for (auto i = 0; i < 3; ++i)
+            read_from(ch, storage[i]);
+
+        write_batch(ch, values, count);
+        REQUIRE(count == 3);
+        for (auto i = 0; i < 3; ++i)
+            REQUIRE(storage[i] == values[i]);
+    }
+
+    SECTION("read from waiting writers")
+    {
+        for (auto i = 0; i < 3; ++i)
+            write_to(ch, values[i]);
+
+        read_batch(ch, gsl::span<uint64_t>{storage}.first(2), count);
+        REQUIRE(count == 2);
+        REQUIRE(storage[0] == 1);
+        REQUIRE(storage[1] == 2);
+
+        // the last one is still waiting
+        read_from(ch, storage[2]);
+        REQUIRE(storage[2] == 3);
+    }
+
+    SECTION("batch writer meets batch reader")
+    {
+        size_t received = 0;
+        write_batch(ch, values, count);
+        REQUIRE(count == 0); // suspended
+
+        read_batch(ch, storage, received);
+        REQUIRE(count == 5);
+        REQUIRE(received == 5);
+        for (auto i = 0; i < 5; ++i)
+            REQUIRE(storage[i] == values[i]);
+    }
+
+    SECTION("single reader takes 1 from waiting batch")
+    {
+        write_batch(ch, values, count);
+        read_from(ch, storage[0]);
+        REQUIRE(count == 1);
+        REQUIRE(storage[0] == 1);
+    }
+
+    SECTION("single writer gives 1 to waiting batch")
+    {
+        read_batch(ch, storage, count);
+        write_to(ch, uint64_t{9});
+        REQUIRE(count == 1);
+        REQUIRE(storage[0] == 9);
+    }
+
+    SECTION("closed")
+    {
+        count = 7;
+        read_batch(ch, storage, count);
+        ch.close();
+        REQUIRE(count == 0);
+
+        count = 7;
+        write_batch(ch, values, count);
+        REQUIRE(count == 0);
+    }
+}
+
+TEST_CASE("buffered channel", "[generic][channel]")
+{
+    using namespace std;
+    using channel_type = buffered_channel<uint64_t, 2, mutex>;
+
+    auto write_count = [](channel_type& ch, uint64_t value,
+                          size_t& count) -> return_frame {
+        auto ok = co_await ch.write(value);
+        test_require_true(ok);
+        count += 1;
+    };
+    auto read_count = [](channel_type& ch, uint64_t& value, bool& ok,
+                         size_t& count) -> return_frame {
+        tie(value, ok) = co_await ch.read();
+        count += 1;
+    };
+
+    channel_type ch{};
+    uint64_t storage = 0;
+    bool ok = false;
+    size_t written = 0, read = 0;
+
+    SECTION("write without suspension while there is room")
+    {
+        frame_t w1 = write_count(ch, 1, written);
+        frame_t w2 = write_count(ch, 2, written);
+        REQUIRE(written == 2); // both completed
+        frame_t w3 = write_count(ch, 3, written);
+        REQUIRE(written == 2); // the buffer is full. suspended
+
+        // read makes a room. the suspended writer completes
+        frame_t r1 = read_count(ch, storage, ok, read);
+        REQUIRE(ok);
+        REQUIRE(storage == 1);
+        REQUIRE(written == 3);
+
+        // FIFO order, including the value of the resumed writer
+        for (uint64_t i : {2, 3})
+        {
+            read_from(ch, storage);
+            REQUIRE(storage == i);
+        }
+        for (auto frame : {w1, w2, w3, r1})
+            frame.destroy();
+    }
+
+    SECTION("read before write")
+    {
+        frame_t r1 = read_count(ch, storage, ok, read);
+        REQUIRE(read == 0); // the buffer is empty. suspended
+
+        // hand off directly to the reader
+        write_to(ch, uint64_t{7});
+        REQUIRE(read == 1);
+        REQUIRE(ok);
+        REQUIRE(storage == 7);
+        r1.destroy();
+    }
+
+    SECTION("cancel when destroy")
+    {
+        auto ch2 = make_unique<channel_type>();
+        frame_t r1 = read_count(*ch2, storage, ok, read);
+        ch2.reset();
+        REQUIRE(read == 1);
+        REQUIRE_FALSE(ok);
+        r1.destroy();
+    }
+}
+
+TEST_CASE("buffered channel close", "[generic][channel]")
+{
+    using namespace std;
+    using channel_type = buffered_channel<uint64_t, 2, mutex>;
+
+    channel_type ch{};
+    uint64_t value = 0;
+    bool ok = false;
+
+    auto read_once = [](channel_type& ch, uint64_t& value,
+                        bool& ok) -> return_ignore {
+        tie(value, ok) = co_await ch.read();
+    };
+    auto write_once = [](channel_type& ch, uint64_t value,
+                         bool& ok) -> return_ignore {
+        ok = co_await ch.write(value);
+    };
+
+    write_once(ch, 3, ok);
+    REQUIRE(ok);
+    ch.close();
+
+    // values in the buffer are still available
+    read_once(ch, value, ok);
+    REQUIRE(ok);
+    REQUIRE(value == 3);
+
+    read_once(ch, value, ok);
+    REQUIRE_FALSE(ok);
+    write_once(ch, 4, ok);
+    REQUIRE_FALSE(ok);
+}
+
+TEST_CASE("buffered channel with threads", "[generic][channel][thread]")
+{
+    using namespace std;
+    using channel_type = buffered_channel<uint64_t, 64, mutex>;
+
+    constexpr uint64_t num_value = 10'000;
+    channel_type ch{};
+    atomic<uint64_t> sum{};
+    atomic<size_t> count{};
+
+    auto produce = [&ch](uint64_t begin, uint64_t end) -> return_ignore {
+        for (auto i = begin; i < end; ++i)
+            co_await ch.write(i);
+    };
+    auto consume = [&ch, &sum, &count]() -> return_ignore {
+        while (count < num_value)
+        {
+            auto [value, ok] = co_await ch.read();
+            if (ok == false)
+                co_return;
+            sum += value;
+            count += 1;
+        }
+    };
+
+    // consumers are resumed by the producers
+    for (auto i = 0; i < 4; ++i)
+        consume();
+
+    thread t1{[&]() { produce(0, num_value / 2); }};
+    thread t2{[&]() { produce(num_value / 2, num_value); }};
+    t1.join();
+    t2.join();
+
+    REQUIRE(count == num_value);
+    REQUIRE(sum == num_value * (num_value - 1) / 2);
+}
+
+// - Note
+//      Move all values from a writer coroutine to a reader coroutine.
+//      `batch` 0 uses `write`/`read` for each value
+auto transfer_with(size_t batch, uint64_t num_value) -> uint64_t
+{
+    using namespace std;
+    using channel_type = channel<uint64_t, mutex>;
+
+    channel_type ch{};
+    vector<uint64_t> values(max<size_t>(batch, 1));
+    uint64_t sum = 0;
+
+    auto consume = [&]() -> return_ignore {
+        vector<uint64_t> storage(values.size());
+        for (uint64_t i = 0; i < num_value;)
+            if (batch == 0)
+            {
+                auto [value, ok] = co_await ch.read();
+                sum += value;
+                i += 1;
+            }
+            else
+            {
+                const auto n = co_await ch.read_n(storage);
+                for (size_t k = 0; k < n; ++k)
+                    sum += storage[k];
+                i += n;
+            }
+    };
+    auto produce = [&]() -> return_ignore {
+        for (uint64_t i = 0; i < num_value;)
+            if (batch == 0)
+            {
+                uint64_t value = i++;
+                co_await ch.write(value);
+            }
+            else
+            {
+                auto chunk = gsl::span<uint64_t>{values}.first(
+                    min<size_t>(batch, num_value - i));
+                for (auto& v : chunk)
+                    v = i++;
+                // wait until the reader takes all
+                while (chunk.empty() == false)
+                    chunk = chunk.subspan(co_await ch.write_n(chunk));
+            }
+    };
+    consume();
+    produce();
+    return sum;
+}
+
+// - Note
+//      Hidden. Run with `[benchmark]` tag
+TEST_CASE("channel batch transfer", "[.][benchmark]")
+{
+    using namespace std::chrono;
+    constexpr uint64_t num_value = 1'000'000;
+
+    for (size_t batch : {0, 1, 16, 64, 256})
+    {
+        stop_watch<high_resolution_clock> watch{};
+        const auto sum = transfer_with(batch, num_value);
+        const auto elapsed = watch.pick<nanoseconds>();
+
+        REQUIRE(sum == num_value * (num_value - 1) / 2);
+        printf("batch %3zu: %lld ns/value\n", batch,
+               static_cast<long long>(elapsed.count() / num_value));
+    }
+}
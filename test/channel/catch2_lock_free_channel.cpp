@@ -0,0 +1,142 @@
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "./channel_test.h"
+#include "stop_watch.hpp"
+#include "suspend/section.h"
+
+using namespace std;
+
+TEST_CASE("lock-free channel", "[generic][channel]")
+{
+    using channel_type = lock_free_channel<uint64_t>;
+
+    channel_type ch{};
+    array<uint64_t, 3> nums{1, 2, 3};
+    uint64_t storage = 0;
+
+    SECTION("write before read")
+    {
+        for (auto i : nums)
+            write_to(ch, i);
+
+        // waiters are LIFO
+        for (auto it = nums.rbegin(); it != nums.rend(); ++it)
+        {
+            read_from(ch, storage);
+            REQUIRE(storage == *it);
+        }
+    }
+
+    SECTION("read before write")
+    {
+        read_from(ch, storage);
+        write_to(ch, uint64_t{7});
+        REQUIRE(storage == 7);
+    }
+
+    SECTION("cancel when destroy")
+    {
+        bool ok = true;
+        auto read_once = [](channel_type& ch, bool& ok) -> return_ignore {
+            uint64_t value{};
+            tie(value, ok) = co_await ch.read();
+        };
+        {
+            channel_type ch2{};
+            read_once(ch2, ok);
+            REQUIRE(ok);
+        }
+        REQUIRE_FALSE(ok);
+    }
+}
+
+// - Note
+//      Start readers and writers in their own threads and
+//      return the sum of delivered values.
+//      The coroutines move between threads when they resume their partner
+template <typename Channel>
+auto exchange_with(Channel& ch, uint32_t num_pair, uint64_t num_value)
+    -> uint64_t
+{
+    atomic<uint64_t> sum{}, count{};
+    const uint64_t num_op = num_value / num_pair;
+
+    auto produce = [&ch, num_op](uint64_t begin) -> return_ignore {
+        for (auto i = begin; i < begin + num_op; ++i)
+            co_await ch.write(i);
+    };
+    auto consume = [&ch, &sum, &count, num_op]() -> return_ignore {
+        for (uint64_t i = 0; i < num_op; ++i)
+        {
+            auto [value, ok] = co_await ch.read();
+            if (ok == false)
+                co_return;
+            sum += value;
+            count += 1;
+        }
+    };
+
+    // the lambdas must outlive the coroutines. don't copy them to threads
+    vector<thread> threads{};
+    for (uint32_t i = 0; i < num_pair; ++i)
+    {
+        threads.emplace_back([&consume]() { consume(); });
+        threads.emplace_back([&produce, i, num_op]() { produce(i * num_op); });
+    }
+    // a suspended coroutine is always resumed by its partner's thread.
+    // after join, all of them are done
+    for (auto& t : threads)
+        t.join();
+
+    test_require_true(count == num_op * num_pair);
+    return sum;
+}
+
+TEST_CASE("lock-free channel with threads", "[generic][channel][thread]")
+{
+    constexpr uint64_t num_value = 10'000;
+    lock_free_channel<uint64_t> ch{};
+
+    for (uint32_t num_pair : {1u, 4u, 16u})
+        REQUIRE(exchange_with(ch, num_pair, num_value) ==
+                num_value * (num_value - 1) / 2);
+}
+
+template <typename Channel>
+void measure_exchange(const char* name)
+{
+    using namespace std::chrono;
+    constexpr uint64_t num_value = 1'000'000;
+
+    for (uint32_t num_pair = 1; num_pair <= 32; num_pair *= 2)
+    {
+        Channel ch{};
+        stop_watch<high_resolution_clock> watch{};
+        const auto sum = exchange_with(ch, num_pair, num_value);
+        const auto elapsed = watch.pick<nanoseconds>();
+
+        const auto count = num_value / num_pair * num_pair;
+        REQUIRE(sum == count * (count - 1) / 2);
+        printf("%s, %2u pairs: %lld ns/op\n", name, num_pair,
+               static_cast<long long>(elapsed.count() / count));
+    }
+}
+
+// - Note
+//      Hidden. Run with `[benchmark]` tag
+TEST_CASE("channel scalability", "[.][benchmark]")
+{
+    measure_exchange<lock_free_channel<uint64_t>>("lock_free_channel");
+    measure_exchange<channel<uint64_t, section>>("channel<section>");
+    measure_exchange<channel<uint64_t, mutex>>("channel<std::mutex>");
+}
@@ -0,0 +1,191 @@
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+#include <catch2/catch.hpp>
+
+#include <coroutine/pipeline.hpp>
+
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "./channel_test.h"
+#include "stop_watch.hpp"
+
+using namespace std;
+
+template <typename T, size_t N, typename L>
+auto write_all(pipeline<T, N, L>& p, uint64_t begin, uint64_t end,
+               size_t& count) -> return_ignore
+{
+    for (auto i = begin; i < end; ++i)
+        if (co_await p.write(i))
+            count += 1;
+}
+
+TEST_CASE("pipeline", "[generic][channel]")
+{
+    using pipeline_type = pipeline<uint64_t, 4, bypass_lock>;
+
+    pipeline_type p{};
+    vector<uint64_t> received{};
+    array<pipeline_stats, 4> stats{};
+    size_t count = 0;
+
+    SECTION("fused map and filter")
+    {
+        p.map([](uint64_t v) { return v * 2; })
+            .filter([](uint64_t v) { return v % 3 == 0; })
+            .map([](uint64_t v) { return v + 1; })
+            .sink([&received](uint64_t v) { received.push_back(v); });
+
+        write_all(p, 0, 10, count);
+        REQUIRE(received == vector<uint64_t>{1, 7, 13, 19});
+
+        // 1 frame for all stages
+        REQUIRE(p.snapshot(stats) == 1);
+        REQUIRE(stats[0].input_count == 10);
+        REQUIRE(stats[0].output_count == 4);
+        REQUIRE(stats[0].depth == 0);
+    }
+
+    SECTION("batch")
+    {
+        vector<size_t> sizes{};
+        p.filter([](uint64_t v) { return v % 2 == 0; })
+            .batch(3)
+            .sink([&](vector<uint64_t> group) {
+                sizes.push_back(group.size());
+                received.insert(received.end(), group.begin(), group.end());
+            });
+
+        write_all(p, 0, 16, count);
+        REQUIRE(sizes == vector<size_t>{3, 3});
+
+        // the last one is smaller
+        p.close();
+        REQUIRE(sizes == vector<size_t>{3, 3, 2});
+        REQUIRE(received == vector<uint64_t>{0, 2, 4, 6, 8, 10, 12, 14});
+
+        REQUIRE(p.snapshot(stats) == 2);
+        REQUIRE(stats[0].input_count == 16);
+        REQUIRE(stats[0].output_count == 3);
+        REQUIRE(stats[1].input_count == 3);
+        REQUIRE(stats[1].output_count == 3);
+    }
+
+    SECTION("backpressure")
+    {
+        // the stage writes to a link which is not read yet
+        auto stage = p.batch(1);
+        write_all(p, 0, 10, count);
+
+        // 4 in the output link, 1 in the stage, 4 in the input link.
+        // the writer is waiting with the last one
+        REQUIRE(count == 9);
+        REQUIRE(p.snapshot(stats) == 1);
+        REQUIRE(stats[0].input_count == 5);
+        REQUIRE(stats[0].output_count == 4);
+        REQUIRE(stats[0].depth == 4);
+
+        std::move(stage).sink([&received](vector<uint64_t> group) {
+            received.push_back(group.at(0));
+        });
+        REQUIRE(count == 10);
+        REQUIRE(received.size() == 10);
+
+        REQUIRE(p.snapshot(stats) == 2);
+        REQUIRE(stats[0].input_count == 10);
+        REQUIRE(stats[0].depth == 0);
+        REQUIRE(stats[1].input_count == 10);
+        REQUIRE(stats[1].depth == 0);
+    }
+}
+
+// - Note
+//      1 stage of hand-made pipeline. A frame and a link for each
+template <typename Link, typename Fn>
+auto relay(Link& in, Link* out, Fn fn, uint64_t& sum) -> return_ignore
+{
+    while (true)
+    {
+        auto [value, ok] = co_await in.read();
+        if (ok == false)
+            break;
+        if (auto result = fn(value))
+        {
+            if (out)
+                co_await out->write(*result);
+            else
+                sum += *result;
+        }
+    }
+    if (out)
+        out->close();
+}
+
+// - Note
+//      map -> filter -> map -> sink with mutex links
+auto run_stages(bool fused, uint64_t num_value) -> uint64_t
+{
+    using link_type = buffered_channel<uint64_t, 64, mutex>;
+
+    auto twice = [](uint64_t v) -> optional<uint64_t> { return v * 2; };
+    auto even = [](uint64_t v) -> optional<uint64_t> {
+        if (v % 4 == 0)
+            return v;
+        return nullopt;
+    };
+    auto plus = [](uint64_t v) -> optional<uint64_t> { return v + 1; };
+
+    uint64_t sum = 0;
+    size_t count = 0;
+    if (fused)
+    {
+        pipeline<uint64_t, 64, mutex> p{};
+        p.map([&](uint64_t v) { return *twice(v); })
+            .filter([&](uint64_t v) { return even(v).has_value(); })
+            .map([&](uint64_t v) { return *plus(v); })
+            .sink([&sum](uint64_t v) { sum += v; });
+        write_all(p, 0, num_value, count);
+        p.close();
+        return sum;
+    }
+
+    link_type l1{}, l2{}, l3{};
+    relay(l3, static_cast<link_type*>(nullptr), plus, sum);
+    relay(l2, &l3, even, sum);
+    relay(l1, &l2, twice, sum);
+    for (uint64_t i = 0; i < num_value; ++i)
+    {
+        uint64_t value = i;
+        write_to(l1, value);
+    }
+    l1.close();
+    return sum;
+}
+
+// - Note
+//      Hidden. Run with `[benchmark]` tag
+TEST_CASE("pipeline fusion", "[.][benchmark]")
+{
+    using namespace std::chrono;
+    constexpr uint64_t num_value = 1'000'000;
+
+    uint64_t expected = 0;
+    for (uint64_t i = 0; i < num_value; i += 2)
+        expected += i * 2 + 1;
+
+    for (bool fused : {false, true})
+    {
+        stop_watch<high_resolution_clock> watch{};
+        const auto sum = run_stages(fused, num_value);
+        const auto elapsed = watch.pick<nanoseconds>();
+
+        REQUIRE(sum == expected);
+        printf("%s: %lld ns/value\n", fused ? "fused  " : "3 links",
+               static_cast<long long>(elapsed.count() / num_value));
+    }
+}
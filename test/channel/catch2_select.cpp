@@ -0,0 +1,160 @@
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <thread>
+
+#include "./channel_test.h"
+
+using namespace std;
+using frame_t = std::experimental::coroutine_handle<void>;
+
+TEST_CASE("select", "[generic][channel]")
+{
+    using channel_type = channel<uint64_t, bypass_lock>;
+
+    channel_type data{}, control{};
+    uint64_t v1 = 0, v2 = 0;
+    size_t index = 0;
+    bool ok = false;
+
+    auto select_read = [](channel_type& ch1, uint64_t& v1, channel_type& ch2,
+                          uint64_t& v2, size_t& index,
+                          bool& ok) -> return_frame {
+        tie(index, ok) = co_await select(on_read(ch1, v1), on_read(ch2, v2));
+    };
+
+    SECTION("ready case completes without suspension")
+    {
+        write_to(control, uint64_t{7});
+        frame_t s = select_read(data, v1, control, v2, index, ok);
+        REQUIRE(index == 1);
+        REQUIRE(ok);
+        REQUIRE(v2 == 7);
+        s.destroy();
+    }
+
+    SECTION("withdraw from the other channels")
+    {
+        frame_t s = select_read(data, v1, control, v2, index, ok);
+        REQUIRE_FALSE(ok); // suspended
+
+        write_to(data, uint64_t{3});
+        REQUIRE(index == 0);
+        REQUIRE(ok);
+        REQUIRE(v1 == 3);
+        s.destroy();
+
+        // the select is not waiting in `control` anymore.
+        // this write suspends until the next read
+        write_to(control, uint64_t{5});
+        read_from(control, v2);
+        REQUIRE(v2 == 5);
+    }
+
+    SECTION("write case")
+    {
+        uint64_t value = 11, storage = 0;
+        auto select_write = [](channel_type& ch1, uint64_t& v1,
+                               channel_type& ch2, uint64_t& v2, size_t& index,
+                               bool& ok) -> return_frame {
+            tie(index, ok) =
+                co_await select(on_read(ch1, v1), on_write(ch2, v2));
+        };
+        frame_t s = select_write(data, v1, control, value, index, ok);
+        REQUIRE_FALSE(ok); // suspended
+
+        read_from(control, storage);
+        REQUIRE(index == 1);
+        REQUIRE(ok);
+        REQUIRE(storage == 11);
+        s.destroy();
+    }
+
+    SECTION("select meets select")
+    {
+        uint64_t value = 13;
+        auto select_write = [](channel_type& ch, uint64_t& v, size_t& index,
+                               bool& ok) -> return_frame {
+            tie(index, ok) = co_await select(on_write(ch, v));
+        };
+        frame_t s1 = select_read(data, v1, control, v2, index, ok);
+
+        size_t index2 = 0;
+        bool ok2 = false;
+        frame_t s2 = select_write(control, value, index2, ok2);
+        REQUIRE(ok);
+        REQUIRE(ok2);
+        REQUIRE(index == 1);
+        REQUIRE(index2 == 0);
+        REQUIRE(v2 == 13);
+        s1.destroy();
+        s2.destroy();
+    }
+
+    SECTION("default branch")
+    {
+        tie(index, ok) = try_select(on_read(data, v1), on_read(control, v2));
+        REQUIRE(index == 2);
+        REQUIRE_FALSE(ok);
+
+        write_to(data, uint64_t{17});
+        tie(index, ok) = try_select(on_read(data, v1), on_read(control, v2));
+        REQUIRE(index == 0);
+        REQUIRE(ok);
+        REQUIRE(v1 == 17);
+    }
+
+    SECTION("cancel when destroy")
+    {
+        auto ch = make_unique<channel_type>();
+        frame_t s = select_read(data, v1, *ch, v2, index, ok);
+        ch.reset();
+        REQUIRE(index == 1);
+        REQUIRE_FALSE(ok);
+        s.destroy();
+    }
+}
+
+TEST_CASE("select with threads", "[generic][channel][thread]")
+{
+    using channel_type = channel<uint64_t, mutex>;
+
+    constexpr uint64_t num_value = 10'000;
+    channel_type data{}, control{};
+    atomic<uint64_t> sum{};
+    atomic<size_t> count{};
+
+    auto produce = [](channel_type& ch, uint64_t begin,
+                      uint64_t end) -> return_ignore {
+        for (auto i = begin; i < end; ++i)
+            co_await ch.write(i);
+    };
+    auto consume = [&data, &control, &sum, &count]() -> return_ignore {
+        uint64_t v1 = 0, v2 = 0;
+        while (count < num_value)
+        {
+            auto [index, ok] =
+                co_await select(on_read(data, v1), on_read(control, v2));
+            if (ok == false)
+                co_return;
+            sum += index == 0 ? v1 : v2;
+            count += 1;
+        }
+    };
+
+    // consumers are resumed by the producers
+    for (auto i = 0; i < 4; ++i)
+        consume();
+
+    thread t1{[&]() { produce(data, 0, num_value / 2); }};
+    thread t2{[&]() { produce(control, num_value / 2, num_value); }};
+    t1.join();
+    t2.join();
+
+    REQUIRE(count == num_value);
+    REQUIRE(sum == num_value * (num_value - 1) / 2);
+}
@@ -30,8 +30,8 @@ struct bypass_lock
 void test_require_true(bool cond);
 
 // ensure successful write to channel
-template <typename E, typename L>
-auto write_to(channel<E, L>& ch, E value, bool ok = false) -> return_ignore
+template <typename E, typename L, typename R>
+auto write_to(channel<E, L, R>& ch, E value, bool ok = false) -> return_ignore
 {
     using namespace std;
 
@@ -48,8 +48,48 @@ auto write_to(channel<E, L>& ch, E value, bool ok = false) -> return_ignore
 }
 
 // ensure successful read from channel
-template <typename E, typename L>
-auto read_from(channel<E, L>& ch, E& value, bool ok = false) -> return_ignore
+template <typename E, typename L, typename R>
+auto read_from(channel<E, L, R>& ch, E& value, bool ok = false) -> return_ignore
+{
+    using namespace std;
+
+    tie(value, ok) = co_await ch.read();
+    test_require_true(ok);
+}
+
+// ensure successful write to buffered channel
+template <typename E, size_t N, typename L>
+auto write_to(buffered_channel<E, N, L>& ch, E value, bool ok = false)
+    -> return_ignore
+{
+    ok = co_await ch.write(value);
+    test_require_true(ok);
+}
+
+// ensure successful read from buffered channel
+template <typename E, size_t N, typename L>
+auto read_from(buffered_channel<E, N, L>& ch, E& value, bool ok = false)
+    -> return_ignore
+{
+    using namespace std;
+
+    tie(value, ok) = co_await ch.read();
+    test_require_true(ok);
+}
+
+// ensure successful write to lock-free channel
+template <typename E>
+auto write_to(lock_free_channel<E>& ch, E value, bool ok = false)
+    -> return_ignore
+{
+    ok = co_await ch.write(value);
+    test_require_true(ok);
+}
+
+// ensure successful read from lock-free channel
+template <typename E>
+auto read_from(lock_free_channel<E>& ch, E& value, bool ok = false)
+    -> return_ignore
 {
     using namespace std;
 
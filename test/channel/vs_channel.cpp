@@ -5,7 +5,9 @@
 //
 // ---------------------------------------------------------------------------
 #include <coroutine/channel.hpp>
+#include <coroutine/pipeline.hpp>
 #include <coroutine/return.h>
+#include <coroutine/suspend.h>
 #include <coroutine/sync.h>
 
 // clang-format off
@@ -141,4 +143,398 @@ class channel_operation_test : public TestClass<channel_operation_test>
         Assert::IsTrue(success == 4);
         Assert::IsTrue(failure == 1);
     }
+
+    TEST_METHOD(channel_close)
+    {
+        uint64_t storage{};
+        uint32_t success{};
+        uint32_t failure{};
+
+        channel_type ch{};
+        read_from(ch, storage, success, failure);
+        ch.close();
+        Assert::IsTrue(failure == 1);
+
+        // complete immediately after close
+        read_from(ch, storage, success, failure);
+        write_to(ch, 1, success, failure);
+        Assert::IsTrue(success == 0);
+        Assert::IsTrue(failure == 3);
+    }
+
+    TEST_METHOD(channel_try_read_write)
+    {
+        uint64_t value = 5, storage{};
+        channel_type ch{};
+
+        Assert::IsFalse(ch.try_read().has_value());
+        Assert::IsFalse(ch.try_write(value));
+
+        read_from(ch, storage);
+        Assert::IsTrue(ch.try_write(value));
+        Assert::IsTrue(storage == 5);
+
+        write_to(ch, 7);
+        Assert::IsTrue(ch.try_read().value() == 7);
+    }
+
+    TEST_METHOD(channel_emplace_and_read_into)
+    {
+        uint64_t storage{};
+        bool ok{};
+
+        auto emplace_one = [](channel_type& ch, uint64_t v) -> return_ignore {
+            co_await ch.emplace(v);
+        };
+        auto read_one = [](channel_type& ch, uint64_t& dst,
+                           bool& ok) -> return_ignore {
+            ok = co_await ch.read_into(dst);
+        };
+
+        channel_type ch{};
+        read_one(ch, storage, ok);
+        emplace_one(ch, 7);
+        Assert::IsTrue(ok);
+        Assert::IsTrue(storage == 7);
+    }
+
+    TEST_METHOD(channel_write_n_to_waiting_readers)
+    {
+        std::array<uint64_t, 4> values{1, 2, 3, 4};
+        uint64_t storage[2]{};
+        size_t count{};
+
+        auto write_batch = [](channel_type& ch, gsl::span<uint64_t> values,
+                              size_t& count) -> return_ignore {
+            count = co_await ch.write_n(values);
+        };
+
+        channel_type ch{};
+        read_from(ch, storage[0]);
+        read_from(ch, storage[1]);
+        // 2 readers can accept
+        write_batch(ch, values, count);
+        Assert::IsTrue(count == 2);
+        Assert::IsTrue(storage[0] == 1);
+        Assert::IsTrue(storage[1] == 2);
+    }
+
+    TEST_METHOD(channel_read_for_timeout)
+    {
+        using namespace std::chrono;
+        uint64_t storage{};
+        auto status = channel_status::success;
+
+        auto read_for = [](channel_type& ch, timer_wheel& wheel,
+                           uint64_t& storage,
+                           channel_status& status) -> return_ignore {
+            std::tie(storage, status) =
+                co_await ch.read_for(milliseconds{1}, wheel);
+        };
+
+        channel_type ch{};
+        timer_wheel wheel{};
+        read_for(ch, wheel, storage, status);
+
+        std::array<coroutine_task_t, 1> buf{};
+        gsl::span<coroutine_task_t> coros{buf};
+        while (wheel.expire(coros) == false)
+        {
+            std::this_thread::sleep_for(milliseconds{1});
+            coros = buf;
+        }
+        coros[0].resume();
+        Assert::IsTrue(status == channel_status::timeout);
+
+        // withdrawn from the channel
+        uint64_t value = 3;
+        Assert::IsFalse(ch.try_write(value));
+    }
+};
+
+class channel_resume_policy_test
+    : public TestClass<channel_resume_policy_test>
+{
+    using channel_type =
+        channel<uint64_t, bypass_lock, resume_on<suspend_queue>>;
+
+  public:
+    TEST_METHOD(channel_writer_posts_the_reader)
+    {
+        suspend_queue sq{};
+        channel_type ch{resume_on{sq}};
+        uint64_t storage{};
+        coroutine_task_t coro{};
+
+        read_from(ch, storage);
+        write_to(ch, uint64_t{3});
+        Assert::IsTrue(storage == 0);
+
+        // the reader resumes from the queue
+        Assert::IsTrue(sq.try_pop(coro));
+        coro.resume();
+        Assert::IsTrue(storage == 3);
+    }
+};
+
+class buffered_channel_test : public TestClass<buffered_channel_test>
+{
+    using channel_type = buffered_channel<uint64_t, 2, bypass_lock>;
+
+    static auto write_to(channel_type& ch, uint64_t value, uint32_t& success,
+                         uint32_t& failure) -> return_ignore
+    {
+        if (co_await ch.write(value))
+            success += 1;
+        else
+            failure += 1;
+    }
+
+    static auto read_from(channel_type& ch, uint64_t& ref, uint32_t& success,
+                          uint32_t& failure) -> return_ignore
+    {
+        auto [value, ok] = co_await ch.read();
+        if (ok == false)
+        {
+            failure += 1;
+            co_return;
+        }
+
+        ref = value;
+        success += 1;
+    }
+
+  public:
+    TEST_METHOD(buffered_channel_write_without_suspension)
+    {
+        uint64_t storage{};
+        uint32_t success{};
+        uint32_t failure{};
+
+        channel_type ch{};
+        // the buffer has room for 2
+        write_to(ch, 1, success, failure);
+        write_to(ch, 2, success, failure);
+        Assert::IsTrue(success == 2);
+        write_to(ch, 3, success, failure);
+        Assert::IsTrue(success == 2);
+
+        // FIFO order, including the value of the resumed writer
+        for (uint64_t i = 1; i <= 3; ++i)
+        {
+            read_from(ch, storage, success, failure);
+            Assert::IsTrue(storage == i);
+        }
+        Assert::IsTrue(success == 6);
+        Assert::IsTrue(failure == 0);
+    }
+
+    TEST_METHOD(buffered_channel_cancel_read_when_destroy)
+    {
+        uint64_t storage{};
+        uint32_t success{};
+        uint32_t failure{};
+        {
+            channel_type ch{};
+            read_from(ch, storage, success, failure);
+        }
+        Assert::IsTrue(success == 0);
+        Assert::IsTrue(failure == 1);
+    }
+};
+
+class lock_free_channel_test : public TestClass<lock_free_channel_test>
+{
+    using channel_type = lock_free_channel<uint64_t>;
+
+    static auto write_to(channel_type& ch, uint64_t value, uint32_t& success,
+                         uint32_t& failure) -> return_ignore
+    {
+        if (co_await ch.write(value))
+            success += 1;
+        else
+            failure += 1;
+    }
+
+    static auto read_from(channel_type& ch, uint64_t& ref, uint32_t& success,
+                          uint32_t& failure) -> return_ignore
+    {
+        auto [value, ok] = co_await ch.read();
+        if (ok == false)
+        {
+            failure += 1;
+            co_return;
+        }
+
+        ref = value;
+        success += 1;
+    }
+
+  public:
+    TEST_METHOD(lock_free_channel_read_before_write)
+    {
+        uint64_t storage{};
+        uint32_t success{};
+        uint32_t failure{};
+
+        channel_type ch{};
+        read_from(ch, storage, success, failure);
+        Assert::IsTrue(success == 0);
+        write_to(ch, 7, success, failure);
+        Assert::IsTrue(storage == 7);
+        Assert::IsTrue(success == 2);
+        Assert::IsTrue(failure == 0);
+    }
+
+    TEST_METHOD(lock_free_channel_cancel_write_when_destroy)
+    {
+        uint32_t success{};
+        uint32_t failure{};
+        {
+            channel_type ch{};
+            write_to(ch, 1, success, failure);
+            write_to(ch, 2, success, failure);
+        }
+        Assert::IsTrue(success == 0);
+        Assert::IsTrue(failure == 2);
+    }
+};
+
+class select_test : public TestClass<select_test>
+{
+    using channel_type = channel<uint64_t, bypass_lock>;
+
+    static auto select_from(channel_type& ch1, uint64_t& v1,
+                            channel_type& ch2, uint64_t& v2, size_t& index,
+                            bool& ok) -> return_ignore
+    {
+        std::tie(index, ok) =
+            co_await select(on_read(ch1, v1), on_read(ch2, v2));
+    }
+
+    static auto write_once(channel_type& ch, uint64_t value) -> return_ignore
+    {
+        co_await ch.write(value);
+    }
+
+  public:
+    TEST_METHOD(select_withdraw_from_the_other_channels)
+    {
+        channel_type data{}, control{};
+        uint64_t v1{}, v2{};
+        size_t index{};
+        bool ok{};
+
+        select_from(data, v1, control, v2, index, ok);
+        Assert::IsFalse(ok);
+
+        write_once(data, 3);
+        Assert::IsTrue(ok);
+        Assert::IsTrue(index == 0);
+        Assert::IsTrue(v1 == 3);
+
+        // stale waiter must not receive this
+        write_once(control, 5);
+        Assert::IsTrue(v2 == 0);
+    }
+
+    TEST_METHOD(select_default_branch)
+    {
+        channel_type data{}, control{};
+        uint64_t v1{}, v2{};
+
+        auto [index, ok] =
+            try_select(on_read(data, v1), on_read(control, v2));
+        Assert::IsTrue(index == 2);
+        Assert::IsFalse(ok);
+    }
+};
+
+class broadcast_channel_test : public TestClass<broadcast_channel_test>
+{
+    using channel_type = broadcast_channel<uint64_t, 1, bypass_lock>;
+    using subscriber_type = subscriber<uint64_t, 1, bypass_lock>;
+
+    static auto write_once(channel_type& ch, uint64_t value, bool& ok)
+        -> return_ignore
+    {
+        ok = co_await ch.write(value);
+    }
+
+    static auto read_once(subscriber_type& sub, const uint64_t*& msg)
+        -> return_ignore
+    {
+        msg = co_await sub.read();
+    }
+
+  public:
+    TEST_METHOD(broadcast_channel_share_the_message)
+    {
+        channel_type ch{};
+        subscriber_type s1{ch}, s2{ch};
+        const uint64_t *m1 = nullptr, *m2 = nullptr;
+        bool ok = false;
+
+        write_once(ch, 7, ok);
+        Assert::IsTrue(ok);
+        read_once(s1, m1);
+        read_once(s2, m2);
+        Assert::IsTrue(m1 == m2);
+        Assert::IsTrue(*m1 == 7);
+    }
+
+    TEST_METHOD(broadcast_channel_drop_oldest)
+    {
+        channel_type ch{broadcast_policy::drop_oldest};
+        subscriber_type slow{ch};
+        const uint64_t* msg = nullptr;
+        bool ok = false;
+
+        write_once(ch, 1, ok);
+        write_once(ch, 2, ok);
+        Assert::IsTrue(ok);
+        read_once(slow, msg);
+        Assert::IsTrue(*msg == 2);
+        Assert::IsTrue(slow.dropped() == 1);
+    }
+};
+
+class pipeline_test : public TestClass<pipeline_test>
+{
+    using pipeline_type = pipeline<uint64_t, 4, bypass_lock>;
+
+    static auto write_all(pipeline_type& p, uint64_t count) -> return_ignore
+    {
+        for (uint64_t i = 0; i < count; ++i)
+            co_await p.write(i);
+    }
+
+  public:
+    TEST_METHOD(pipeline_fuse_map_and_filter)
+    {
+        pipeline_type p{};
+        std::vector<uint64_t> received{};
+        p.map([](uint64_t v) { return v * 2; })
+            .filter([](uint64_t v) { return v % 3 == 0; })
+            .sink([&received](uint64_t v) { received.push_back(v); });
+        write_all(p, 6);
+        Assert::IsTrue(received == std::vector<uint64_t>{0, 6});
+
+        std::array<pipeline_stats, 2> stats{};
+        Assert::IsTrue(p.snapshot(stats) == 1);
+        Assert::IsTrue(stats[0].input_count == 6);
+        Assert::IsTrue(stats[0].output_count == 2);
+    }
+
+    TEST_METHOD(pipeline_flush_batch_on_close)
+    {
+        pipeline_type p{};
+        std::vector<size_t> sizes{};
+        p.batch(4).sink([&sizes](std::vector<uint64_t> group) {
+            sizes.push_back(group.size());
+        });
+        write_all(p, 6);
+        p.close();
+        Assert::IsTrue(sizes == std::vector<size_t>{4, 2});
+    }
 };
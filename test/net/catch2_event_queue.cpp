@@ -0,0 +1,122 @@
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+#include <catch2/catch.hpp>
+
+#include <coroutine/net.h>
+#include <coroutine/return.h>
+#include <coroutine/suspend.h>
+
+#include <atomic>
+#include <system_error>
+#include <thread>
+
+#include "stop_watch.hpp"
+
+using namespace std;
+using namespace std::chrono;
+using namespace std::literals;
+
+#if defined(__linux__)
+
+TEST_CASE("suspend_queue with event mode", "[network][suspend]")
+{
+    suspend_queue sq{suspend_queue::mode::event};
+
+    auto routine = [&sq](std::atomic<size_t>& count) -> return_ignore {
+        co_await sq.wait(); // resumed by the I/O loop
+        count += 1;
+    };
+    std::atomic<size_t> count{};
+
+    SECTION("wake up the I/O loop")
+    {
+        thread pusher{[&]() {
+            this_thread::sleep_for(100ms);
+            routine(count);
+        }};
+
+        // the loop must wake up before the timeout
+        stop_watch<steady_clock> watch{};
+        while (count == 0 && watch.pick<seconds>() < 10s)
+            for (auto task : wait_io_tasks(10s))
+                task.resume();
+        REQUIRE_NOTHROW(pusher.join());
+
+        REQUIRE(count == 1);
+        REQUIRE(watch.pick<seconds>() < 5s);
+    }
+
+    SECTION("burst of push")
+    {
+        constexpr size_t num_task = 1000;
+        for (size_t i = 0; i < num_task; ++i)
+            routine(count);
+
+        // the signals are coalesced, but all coroutines are yielded
+        for (auto task : wait_io_tasks(1s))
+            task.resume();
+        REQUIRE(count == num_task);
+
+        // the drain is counted as pop
+#if defined(USE_SUSPEND_QUEUE_STATS)
+        suspend_queue_stats stats{};
+        REQUIRE(sq.snapshot(stats));
+        REQUIRE(stats.push_count == num_task);
+        REQUIRE(stats.pop_count == num_task);
+#endif
+
+        // no more signal. timeout
+        stop_watch<steady_clock> watch{};
+        for (auto task : wait_io_tasks(200ms))
+            task.resume();
+        REQUIRE(watch.pick<milliseconds>() >= 150ms);
+    }
+
+    SECTION("re-await in the drain")
+    {
+        auto loop = [&sq](std::atomic<size_t>& count) -> return_ignore {
+            for (auto i = 0; i < 3; ++i)
+            {
+                co_await sq.wait();
+                count += 1;
+            }
+        };
+        loop(count);
+
+        // the coroutine pushed again is left for the next drain.
+        // both epoll instances drain once, so it is yielded 2 times at most
+        size_t yielded = 0;
+        for (auto task : wait_io_tasks(1s))
+        {
+            task.resume();
+            yielded += 1;
+        }
+        REQUIRE(yielded <= 2);
+        REQUIRE(count == yielded);
+
+        while (count < 3)
+            for (auto task : wait_io_tasks(1s))
+                task.resume();
+    }
+
+    SECTION("pop without the I/O loop")
+    {
+        routine(count);
+        coroutine_task_t coro{};
+        REQUIRE(sq.try_pop(coro));
+        coro.resume();
+        REQUIRE(count == 1);
+    }
+}
+
+#else
+
+TEST_CASE("suspend_queue with event mode", "[network][suspend]")
+{
+    REQUIRE_THROWS_AS(suspend_queue{suspend_queue::mode::event},
+                      std::system_error);
+}
+
+#endif
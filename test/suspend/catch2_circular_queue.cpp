@@ -0,0 +1,144 @@
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <memory>
+
+#include "stop_watch.hpp"
+#include "suspend/circular_queue.hpp"
+
+using namespace std;
+
+TEST_CASE("bounded circular queue", "[suspend]")
+{
+    bounded_circular_queue_t<uint64_t, 8> cq{};
+    uint64_t value = 0;
+
+    SECTION("use all slots")
+    {
+        for (uint64_t i = 0; i < 8; ++i)
+            REQUIRE(cq.push(i));
+        REQUIRE(cq.is_full());
+        REQUIRE(cq.size() == 8);
+        REQUIRE_FALSE(cq.push(8));
+
+        for (uint64_t i = 0; i < 8; ++i)
+        {
+            REQUIRE(cq.try_pop(value));
+            REQUIRE(value == i);
+        }
+        REQUIRE(cq.empty());
+        REQUIRE_FALSE(cq.try_pop(value));
+    }
+
+    SECTION("wrap around")
+    {
+        // the indices pass the capacity many times
+        for (uint64_t i = 0; i < 1000; ++i)
+        {
+            REQUIRE(cq.push(i));
+            REQUIRE(cq.push(i + 1));
+            REQUIRE(cq.try_pop(value));
+            REQUIRE(value == i);
+            REQUIRE(cq.try_pop(value));
+            REQUIRE(value == i + 1);
+        }
+        REQUIRE(cq.empty());
+    }
+}
+
+// - Note
+//      The ring before power of 2 capacity. Only for comparison
+template <typename ElemType>
+class legacy_circular_queue_t
+{
+    static constexpr auto capacity = 500 + 1;
+
+  public:
+    using value_type = ElemType;
+    using index_type = uint16_t;
+
+  private:
+    index_type begin = 0;
+    index_type end = 0;
+    std::array<value_type, capacity> storage{};
+
+  public:
+    static index_type next(index_type i) noexcept
+    {
+        return (i + 1) % capacity;
+    }
+
+  public:
+    bool is_full() const noexcept
+    {
+        return next(end) == begin;
+    }
+    bool empty() const noexcept
+    {
+        return begin == end;
+    }
+
+    bool push(const value_type& msg) noexcept
+    {
+        if (is_full())
+            return false;
+
+        const auto index = end;
+        end = next(end); // increase count;
+
+        storage.at(index) = msg; // expect copy
+        return true;
+    }
+
+    [[nodiscard]] bool try_pop(value_type& msg) noexcept
+    {
+        if (empty())
+            return false;
+
+        const auto index = begin;
+        begin = next(begin); // decrease count;
+
+        msg = std::move(storage.at(index)); // expect move
+        return true;
+    }
+};
+
+template <typename Queue>
+auto measure_push_pop(Queue& q) -> std::chrono::nanoseconds
+{
+    using namespace std::chrono;
+    constexpr size_t num_round = 100'000, num_elem = 400;
+
+    uint64_t value = 0, sum = 0;
+    stop_watch<high_resolution_clock> watch{};
+    for (size_t r = 0; r < num_round; ++r)
+    {
+        for (uint64_t i = 0; i < num_elem; ++i)
+            q.push(i);
+        while (q.try_pop(value))
+            sum += value;
+    }
+    const auto elapsed = watch.pick<nanoseconds>();
+    REQUIRE(sum == num_round * (num_elem * (num_elem - 1) / 2));
+    return elapsed / (num_round * num_elem);
+}
+
+// - Note
+//      Hidden. Run with `[benchmark]` tag
+TEST_CASE("bounded circular queue push/pop", "[.][benchmark]")
+{
+    auto legacy = make_unique<legacy_circular_queue_t<uint64_t>>();
+    auto masked = make_unique<bounded_circular_queue_t<uint64_t, 512>>();
+    auto large = make_unique<bounded_circular_queue_t<uint64_t, 1 << 20>>();
+
+    printf("legacy(501, modulo): %lld ns/op\n",
+           static_cast<long long>(measure_push_pop(*legacy).count()));
+    printf("masked(512): %lld ns/op\n",
+           static_cast<long long>(measure_push_pop(*masked).count()));
+    printf("masked(1M): %lld ns/op\n",
+           static_cast<long long>(measure_push_pop(*large).count()));
+}
@@ -0,0 +1,115 @@
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#include "stop_watch.hpp"
+#include "suspend/section.h"
+
+using namespace std;
+
+// - Note
+//      Increase the counter with the lock from multiple threads
+template <typename Lockable>
+auto increase_with(Lockable& mtx, uint32_t num_thread, size_t num_loop)
+    -> size_t
+{
+    size_t counter = 0;
+    vector<thread> threads{};
+    for (uint32_t i = 0; i < num_thread; ++i)
+        threads.emplace_back([&mtx, &counter, num_loop]() {
+            for (size_t k = 0; k < num_loop; ++k)
+            {
+                unique_lock lck{mtx};
+                counter += 1;
+            }
+        });
+    for (auto& t : threads)
+        t.join();
+    return counter;
+}
+
+TEST_CASE("section", "[suspend][thread]")
+{
+    section mtx{};
+
+    SECTION("try lock")
+    {
+        REQUIRE(mtx.try_lock());
+        REQUIRE_FALSE(mtx.try_lock());
+        mtx.unlock();
+        REQUIRE(mtx.try_lock());
+        mtx.unlock();
+    }
+
+    SECTION("mutual exclusion")
+    {
+        constexpr size_t num_loop = 100'000;
+        for (uint32_t num_thread : {1u, 2u, 8u})
+            REQUIRE(increase_with(mtx, num_thread, num_loop) ==
+                    num_thread * num_loop);
+    }
+}
+
+#if !defined(_WIN32)
+// - Note
+//      The lock before the futex based `section`. Only for comparison
+class rwlock_t final
+{
+    pthread_rwlock_t rwlock = PTHREAD_RWLOCK_INITIALIZER;
+
+  public:
+    ~rwlock_t() noexcept
+    {
+        pthread_rwlock_destroy(&rwlock);
+    }
+    void lock() noexcept
+    {
+        pthread_rwlock_wrlock(&rwlock);
+    }
+    void unlock() noexcept
+    {
+        pthread_rwlock_unlock(&rwlock);
+    }
+};
+#endif
+
+template <typename Lockable>
+void measure_contention(const char* name)
+{
+    using namespace std::chrono;
+    constexpr size_t num_op = 1'000'000;
+
+    for (uint32_t num_thread = 1; num_thread <= 64; num_thread *= 2)
+    {
+        Lockable mtx{};
+        stop_watch<high_resolution_clock> watch{};
+        const auto count = increase_with(mtx, num_thread, num_op / num_thread);
+        const auto elapsed = watch.pick<nanoseconds>();
+
+        REQUIRE(count == num_op / num_thread * num_thread);
+        printf("%s, %2u threads: %lld ns/op\n", name, num_thread,
+               static_cast<long long>(elapsed.count() / count));
+    }
+}
+
+// - Note
+//      Hidden. Run with `[benchmark]` tag
+TEST_CASE("section contention", "[.][benchmark]")
+{
+    measure_contention<section>("section");
+#if !defined(_WIN32)
+    measure_contention<rwlock_t>("pthread_rwlock");
+#endif
+    measure_contention<std::mutex>("std::mutex");
+}
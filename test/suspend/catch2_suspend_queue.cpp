@@ -8,9 +8,12 @@
 #include <coroutine/suspend.h>
 #include <coroutine/sync.h>
 
+#include <array>
 #include <atomic>
 #include <gsl/gsl>
+#include <vector>
 
+#include "stop_watch.hpp"
 #include "./suspend_test.h"
 
 using namespace std;
@@ -164,3 +167,514 @@ TEST_CASE("suspend_queue", "[suspend][thread]")
 
     // test end
 }
+
+TEST_CASE("suspend_queue with lock-free mode", "[suspend][thread]")
+{
+    suspend_queue sq{suspend_queue::mode::lock_free};
+
+    SECTION("no thread")
+    {
+        auto routine = [&sq](int& status) -> return_ignore {
+            status = 1;
+            co_await sq.wait();
+            status = 2;
+        };
+
+        int status = 0;
+        routine(status);
+        REQUIRE(status == 1);
+
+        coroutine_task_t coro{};
+        REQUIRE(sq.try_pop(coro));
+        REQUIRE_NOTHROW(coro.resume());
+        REQUIRE(status == 2);
+
+        // nothing left in the queue
+        REQUIRE_FALSE(sq.try_pop(coro));
+    }
+
+    SECTION("multiple producer multiple consumer")
+    {
+        constexpr size_t num_task = 100;
+        std::atomic<size_t> count{};
+
+        auto routine = [&sq](std::atomic<size_t>& count) -> return_ignore {
+            co_await sq.wait(); // just wait schedule
+            count += 1;
+        };
+        auto spawn = [&]() {
+            for (size_t i = 0; i < num_task; ++i)
+                routine(count);
+        };
+        auto resume_until_done = [&]() {
+            coroutine_task_t coro{};
+            while (count < 3 * num_task)
+                if (sq.try_pop(coro))
+                    coro.resume();
+                else
+                    this_thread::yield();
+        };
+
+        thread w1{resume_until_done}, w2{resume_until_done};
+        thread p1{spawn}, p2{spawn}, p3{spawn};
+
+        REQUIRE_NOTHROW(p1.join(), p2.join(), p3.join());
+        REQUIRE_NOTHROW(w1.join(), w2.join());
+        REQUIRE(count == 3 * num_task);
+    }
+
+    // test end
+}
+
+TEST_CASE("suspend_queue with unbounded mode", "[suspend]")
+{
+    suspend_queue sq{suspend_queue::mode::unbounded};
+
+    auto routine = [&sq](std::atomic<size_t>& count) -> return_ignore {
+        co_await sq.wait(); // just wait schedule
+        count += 1;
+    };
+
+    // much more than the capacity of bounded queues
+    constexpr size_t num_task = 10'000;
+    std::atomic<size_t> count{};
+
+    for (auto repeat = 0; repeat < 2; ++repeat)
+    {
+        // push never throws
+        for (size_t i = 0; i < num_task; ++i)
+            REQUIRE_NOTHROW(routine(count));
+
+        coroutine_task_t coro{};
+        while (sq.try_pop(coro))
+            coro.resume();
+
+        REQUIRE(count == num_task * (repeat + 1));
+    }
+}
+
+TEST_CASE("suspend_queue with large capacity", "[suspend]")
+{
+    // the smallest tier which can hold it is 2^20
+    suspend_queue sq{suspend_queue::mode::lock_cond, 100'000};
+
+    auto routine = [&sq](size_t& count) -> return_ignore {
+        co_await sq.wait(); // just wait schedule
+        count += 1;
+    };
+
+    constexpr size_t num_task = 100'000;
+    size_t count = 0;
+    for (size_t i = 0; i < num_task; ++i)
+        REQUIRE_NOTHROW(routine(count));
+
+    coroutine_task_t coro{};
+    while (sq.try_pop(coro))
+        coro.resume();
+    REQUIRE(count == num_task);
+
+    REQUIRE_THROWS(suspend_queue{suspend_queue::mode::lock_cond, 1 << 23});
+}
+
+TEST_CASE("suspend_queue batch operation", "[suspend]")
+{
+    // collect suspended coroutines with hooks
+    auto routine = [](suspend_hook& hook, size_t& count) -> return_ignore {
+        co_await hook;
+        count += 1;
+    };
+
+    for (auto mode : {suspend_queue::mode::lock_cond,
+                      suspend_queue::mode::lock_free,
+                      suspend_queue::mode::unbounded,
+                      suspend_queue::mode::sharded,
+                      suspend_queue::mode::spsc})
+    {
+        suspend_queue sq{mode};
+
+        size_t count = 0;
+        std::array<suspend_hook, 20> hooks{};
+        std::array<coroutine_task_t, 20> tasks{};
+        for (size_t i = 0; i < hooks.size(); ++i)
+        {
+            routine(hooks[i], count);
+            tasks[i] = hooks[i];
+        }
+
+        REQUIRE_NOTHROW(sq.push_n(tasks));
+
+        std::array<coroutine_task_t, 15> buf{};
+        gsl::span<coroutine_task_t> popped{buf};
+        REQUIRE(sq.try_pop_n(popped));
+        REQUIRE(popped.size() == 15); // limited by the span
+        for (auto coro : popped)
+            coro.resume();
+
+        popped = buf;
+        REQUIRE(sq.try_pop_n(popped));
+        REQUIRE(popped.size() == 5); // remaining coroutines
+        for (auto coro : popped)
+            coro.resume();
+
+        popped = buf;
+        REQUIRE_FALSE(sq.try_pop_n(popped));
+        REQUIRE(popped.empty());
+        REQUIRE(count == 20);
+    }
+}
+
+TEST_CASE("suspend_queue stats", "[suspend]")
+{
+    suspend_queue sq{suspend_queue::mode::lock_free};
+    suspend_queue_stats stats{};
+
+    // the frames are never resumed. use fake addresses
+    std::array<coroutine_task_t, 10> tasks{};
+    for (size_t i = 0; i < tasks.size(); ++i)
+        tasks[i] = coroutine_task_t::from_address(&tasks[i]);
+
+    for (auto task : tasks)
+        sq.push(task);
+    sq.push_n(tasks);
+
+    coroutine_task_t coro{};
+    for (size_t i = 0; i < tasks.size(); ++i)
+        REQUIRE(sq.try_pop(coro));
+    std::array<coroutine_task_t, 20> buf{};
+    gsl::span<coroutine_task_t> popped{buf};
+    REQUIRE(sq.try_pop_n(popped));
+    REQUIRE(popped.size() == tasks.size());
+
+#if !defined(USE_SUSPEND_QUEUE_STATS)
+    // compiled out. nothing is counted
+    REQUIRE_FALSE(sq.snapshot(stats));
+    REQUIRE(stats.push_count == 0);
+    REQUIRE(stats.pop_count == 0);
+#else
+    REQUIRE(sq.snapshot(stats));
+    REQUIRE(stats.push_count == 20);
+    REQUIRE(stats.pop_count == 20);
+    REQUIRE(stats.retry_count == 0);
+
+    uint64_t sum = 0;
+    for (auto count : stats.latency)
+        sum += count;
+    REQUIRE(sum == 20);
+
+    SECTION("retry when full")
+    {
+        // lock-free ring has 512 slots
+        REQUIRE_THROWS([&]() {
+            for (auto i = 0; i < 1000; ++i)
+                sq.push(tasks[0]);
+        }());
+        REQUIRE(sq.snapshot(stats));
+        REQUIRE(stats.retry_count > 0);
+        REQUIRE(stats.push_count - stats.pop_count > 0); // depth
+    }
+#endif
+}
+
+TEST_CASE("suspend_queue resume batch", "[suspend]")
+{
+    using namespace std::chrono;
+
+    suspend_queue sq{};
+    size_t count = 0;
+
+    auto routine = [&sq](size_t& count) -> return_ignore {
+        co_await sq.wait(); // just wait schedule
+        count += 1;
+    };
+    auto slow_routine = [&sq](size_t& count) -> return_ignore {
+        co_await sq.wait();
+        this_thread::sleep_for(10ms);
+        count += 1;
+    };
+
+    SECTION("empty")
+    {
+        REQUIRE(sq.resume_batch(10, 1s) == 0);
+    }
+
+    SECTION("limited by count")
+    {
+        for (auto i = 0; i < 25; ++i)
+            routine(count);
+
+        REQUIRE(sq.resume_batch(10, 1s) == 10);
+        REQUIRE(count == 10);
+        REQUIRE(sq.resume_batch(10, 1s) == 10);
+        REQUIRE(sq.resume_batch(10, 1s) == 5); // the queue is empty
+        REQUIRE(count == 25);
+    }
+
+    SECTION("no budget")
+    {
+        for (auto i = 0; i < 3; ++i)
+            routine(count);
+
+        REQUIRE(sq.resume_batch(0, 1s) == 0);
+        REQUIRE(sq.resume_batch(10, 0s) == 0);
+        REQUIRE(count == 0);
+        REQUIRE(sq.resume_batch(10, 1s) == 3);
+    }
+
+    SECTION("limited by time")
+    {
+        for (auto i = 0; i < 10; ++i)
+            slow_routine(count);
+
+        // at least 1 coroutine is resumed
+        const auto n = sq.resume_batch(100, 25ms);
+        REQUIRE(n >= 1);
+        REQUIRE(n < 10);
+        REQUIRE(count == n);
+
+        // remaining coroutines are still in the queue
+        REQUIRE(sq.resume_batch(100, 10s) == 10 - n);
+        REQUIRE(count == 10);
+    }
+}
+
+TEST_CASE("suspend_queue blocking wait", "[suspend][thread]")
+{
+    using namespace std::chrono;
+
+    suspend_queue sq{};
+    coroutine_task_t coro{};
+
+    SECTION("timeout")
+    {
+        stop_watch<steady_clock> watch{};
+        REQUIRE_FALSE(sq.wait_pop(coro, 200ms));
+        REQUIRE(watch.pick<milliseconds>() >= 199ms); // allow misc error
+    }
+
+    SECTION("wake up by push")
+    {
+        thread_id_t id1{}, id2{};
+        auto routine = [&sq](thread_id_t& invoke_id,
+                             thread_id_t& resume_id) -> return_ignore {
+            invoke_id = get_current_thread_id();
+            co_await sq.wait();
+            resume_id = get_current_thread_id();
+        };
+
+        stop_watch<steady_clock> watch{};
+        thread worker{[&sq]() {
+            coroutine_task_t coro{};
+            if (sq.wait_pop(coro, 10s))
+                coro.resume();
+        }};
+
+        this_thread::sleep_for(100ms);
+        routine(id1, id2);
+        REQUIRE_NOTHROW(worker.join());
+
+        REQUIRE(watch.pick<seconds>() < 10s); // woken before the timeout
+        REQUIRE(id1 != id2);
+        REQUIRE(id1 == get_current_thread_id());
+    }
+
+    SECTION("no timeout")
+    {
+        size_t count = 0;
+        auto routine = [&sq](size_t& count) -> return_ignore {
+            co_await sq.wait();
+            count += 1;
+        };
+
+        // `duration::max()` must not overflow to the past
+        bool popped = false;
+        thread worker{[&sq, &popped]() {
+            coroutine_task_t coro{};
+            popped = sq.wait_pop(coro, suspend_queue::duration::max());
+            if (popped)
+                coro.resume();
+        }};
+
+        this_thread::sleep_for(100ms);
+        routine(count);
+        REQUIRE_NOTHROW(worker.join());
+        REQUIRE(popped);
+        REQUIRE(count == 1);
+    }
+}
+
+TEST_CASE("suspend_queue with priority mode", "[suspend]")
+{
+    suspend_queue sq{suspend_queue::mode::priority};
+
+    auto routine = [&sq](uint32_t priority,
+                         std::vector<uint32_t>& order) -> return_ignore {
+        co_await sq.wait(priority);
+        order.emplace_back(priority);
+    };
+    auto resume_all = [&sq]() {
+        coroutine_task_t coro{};
+        while (sq.try_pop(coro))
+            coro.resume();
+    };
+
+    std::vector<uint32_t> order{};
+
+    SECTION("urgent first")
+    {
+        for (auto priority : {7u, 0u, 3u, 0u, 5u})
+            routine(priority, order);
+
+        resume_all();
+        REQUIRE(order == std::vector<uint32_t>{0, 0, 3, 5, 7});
+    }
+
+    SECTION("least urgent level is not starved")
+    {
+        routine(suspend_queue::priority_levels - 1, order);
+        for (auto i = 0; i < 100; ++i)
+            routine(0, order);
+
+        resume_all();
+        REQUIRE(order.size() == 101);
+        // the least urgent one is served before urgent ones are drained
+        REQUIRE(order.back() == 0);
+    }
+}
+
+TEST_CASE("suspend_queue with sharded mode", "[suspend][thread]")
+{
+    suspend_queue sq{suspend_queue::mode::sharded};
+
+    auto routine = [&sq](std::atomic<size_t>& count) -> return_ignore {
+        co_await sq.wait(); // just wait schedule
+        count += 1;
+    };
+
+    SECTION("no locality for other modes")
+    {
+        suspend_queue other{};
+        uint64_t local = 1, remote = 1;
+        REQUIRE_FALSE(other.locality(local, remote));
+        REQUIRE(local == 0);
+        REQUIRE(remote == 0);
+    }
+
+    SECTION("resume in pinned threads")
+    {
+        constexpr size_t num_task = 1000;
+        const auto num_thread = std::max(2u, thread::hardware_concurrency());
+        std::atomic<size_t> count{};
+
+        // each thread resumes what it suspended, unless others steal them
+        auto run = [&](uint32_t cpu) {
+            pin_current_thread(cpu);
+            for (size_t i = 0; i < num_task; ++i)
+                routine(count);
+
+            coroutine_task_t coro{};
+            while (count < num_thread * num_task)
+                if (sq.try_pop(coro))
+                    coro.resume();
+                else
+                    this_thread::yield();
+        };
+
+        std::vector<thread> threads{};
+        for (uint32_t cpu = 0; cpu < num_thread; ++cpu)
+            threads.emplace_back(run, cpu);
+        for (auto& t : threads)
+            REQUIRE_NOTHROW(t.join());
+        REQUIRE(count == num_thread * num_task);
+
+        uint64_t local = 0, remote = 0;
+        REQUIRE(sq.locality(local, remote));
+        REQUIRE(local + remote == num_thread * num_task);
+        REQUIRE(local > 0);
+    }
+
+    SECTION("steal from other shard")
+    {
+        std::atomic<size_t> count{};
+        thread producer{[&]() {
+            pin_current_thread(0);
+            routine(count);
+        }};
+        REQUIRE_NOTHROW(producer.join());
+
+        // the coroutine is in some shard. find it anyway
+        coroutine_task_t coro{};
+        REQUIRE(sq.try_pop(coro));
+        coro.resume();
+        REQUIRE(count == 1);
+    }
+}
+
+TEST_CASE("suspend_queue with spsc mode", "[suspend][thread]")
+{
+    suspend_queue sq{suspend_queue::mode::spsc};
+
+    auto routine = [&sq](std::atomic<size_t>& count) -> return_ignore {
+        co_await sq.wait(); // just wait schedule
+        count += 1;
+    };
+
+    // 1 producer, 1 consumer.
+    // the ring is bounded. push in chunks to wrap around it many times
+    constexpr size_t num_chunk = 100, chunk_size = 1000;
+    std::atomic<size_t> count{};
+    thread consumer{[&sq, &count]() {
+        coroutine_task_t coro{};
+        while (count < num_chunk * chunk_size)
+            if (sq.wait_pop(coro, 1s))
+                coro.resume();
+    }};
+    for (size_t c = 1; c <= num_chunk; ++c)
+    {
+        for (size_t i = 0; i < chunk_size; ++i)
+            REQUIRE_NOTHROW(routine(count));
+        while (count < c * chunk_size)
+            this_thread::yield();
+    }
+    REQUIRE_NOTHROW(consumer.join());
+    REQUIRE(count == num_chunk * chunk_size);
+}
+
+// - Note
+//      Average handoff time between 2 threads.
+//      Hidden. Run with `[benchmark]` tag
+TEST_CASE("suspend_queue handoff latency", "[.][benchmark]")
+{
+    using namespace std::chrono;
+    constexpr size_t num_task = 1'000'000;
+    constexpr size_t window = 256; // less than the capacity of bounded modes
+
+    for (auto mode : {suspend_queue::mode::lock_cond,
+                      suspend_queue::mode::lock_free,
+                      suspend_queue::mode::spsc})
+    {
+        suspend_queue sq{mode};
+        std::atomic<size_t> popped{};
+
+        stop_watch<high_resolution_clock> watch{};
+        thread consumer{[&sq, &popped]() {
+            coroutine_task_t coro{};
+            while (popped.load(memory_order_relaxed) < num_task)
+                if (sq.try_pop(coro))
+                    popped.fetch_add(1, memory_order_relaxed);
+                else
+                    this_thread::yield();
+        }};
+        // the frames are never resumed. use fake addresses
+        for (size_t i = 1; i <= num_task; ++i)
+        {
+            while (i - popped.load(memory_order_relaxed) > window)
+                this_thread::yield();
+            sq.push(coroutine_task_t::from_address(reinterpret_cast<void*>(i)));
+        }
+        consumer.join();
+
+        const auto elapsed = watch.pick<nanoseconds>();
+        printf("mode %u: %lld ns/op\n", static_cast<uint32_t>(mode),
+               static_cast<long long>(elapsed.count() / num_task));
+    }
+}
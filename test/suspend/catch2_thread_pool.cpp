@@ -0,0 +1,139 @@
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+#include <catch2/catch.hpp>
+
+#include <coroutine/return.h>
+#include <coroutine/suspend.h>
+#include <coroutine/sync.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "./suspend_test.h"
+#include "suspend/work_stealing_deque.hpp"
+
+using namespace std;
+using namespace std::literals;
+
+TEST_CASE("thread_pool", "[suspend][thread]")
+{
+    thread_pool pool{4};
+
+    SECTION("schedule to worker")
+    {
+        wait_group wg{};
+        wg.add(1);
+
+        auto routine = [&pool](wait_group& wg, thread_id_t& invoke_id,
+                               thread_id_t& resume_id) -> return_ignore {
+            invoke_id = get_current_thread_id();
+            co_await pool.schedule();
+            resume_id = get_current_thread_id();
+            wg.done();
+        };
+
+        thread_id_t id1{}, id2{};
+        routine(wg, id1, id2);
+
+        REQUIRE(wg.wait(10s));
+        REQUIRE(id1 == get_current_thread_id()); // invoke id == this thread
+        REQUIRE(id1 != id2);                     // resume id == worker thread
+    }
+
+    SECTION("reschedule in worker")
+    {
+        constexpr uint16_t num_task = 1000;
+        std::atomic<size_t> count{};
+        wait_group wg{};
+        wg.add(num_task);
+
+        // after the first schedule, the coroutine is in a worker.
+        // so following schedules will use the worker's own deque
+        auto routine = [&pool](wait_group& wg,
+                               std::atomic<size_t>& count) -> return_ignore {
+            for (auto i = 0; i < 10; ++i)
+            {
+                co_await pool.schedule();
+                count += 1;
+            }
+            wg.done();
+        };
+        for (auto i = 0; i < num_task; ++i)
+            routine(wg, count);
+
+        REQUIRE(wg.wait(10s));
+        REQUIRE(count == num_task * 10);
+    }
+}
+
+TEST_CASE("thread_pool destruction", "[suspend][thread]")
+{
+    std::atomic<size_t> count{};
+
+    auto routine = [](thread_pool& pool,
+                      std::atomic<size_t>& count) -> return_ignore {
+        co_await pool.schedule();
+        count += 1;
+    };
+    {
+        thread_pool pool{2};
+        for (auto i = 0; i < 100; ++i)
+            routine(pool, count);
+    }
+    // remaining coroutines are resumed before the workers exit
+    REQUIRE(count == 100);
+}
+
+TEST_CASE("work stealing deque race on the last item", "[suspend][thread]")
+{
+    // the owner and the thieves compete for the only item each time.
+    // each item must be taken exactly once
+    constexpr size_t num_item = 100'000;
+    work_stealing_deque_t<64> deque{};
+    auto takes = make_unique<std::atomic<uint32_t>[]>(num_item);
+    std::atomic<bool> done{};
+    std::atomic<uint32_t> ready{};
+
+    auto take = [&takes](void* ptr) {
+        takes[reinterpret_cast<uintptr_t>(ptr) - 1] += 1;
+    };
+    vector<thread> thieves{};
+    for (auto i = 0; i < 3; ++i)
+        thieves.emplace_back([&deque, &done, &ready, &take]() {
+            ready += 1;
+            while (done == false)
+            {
+                void* ptr = nullptr;
+                if (deque.steal(ptr))
+                    take(ptr);
+            }
+        });
+
+    while (ready < thieves.size())
+        this_thread::yield();
+
+    size_t lost = 0;
+    for (uintptr_t i = 1; i <= num_item; ++i)
+    {
+        REQUIRE(deque.push(reinterpret_cast<void*>(i)));
+        void* ptr = nullptr;
+        if (deque.pop(ptr))
+            take(ptr);
+        else if (ptr != nullptr)
+            ++lost; // `pop` failed, but wrote the stolen item
+    }
+    done = true;
+    for (auto& t : thieves)
+        t.join();
+
+    REQUIRE(lost == 0);
+    size_t wrong = 0;
+    for (size_t i = 0; i < num_item; ++i)
+        if (takes[i] != 1)
+            ++wrong;
+    REQUIRE(wrong == 0);
+}
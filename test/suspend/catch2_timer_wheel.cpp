@@ -0,0 +1,208 @@
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+#include <catch2/catch.hpp>
+
+#include <coroutine/return.h>
+#include <coroutine/suspend.h>
+
+#include <array>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace std::literals;
+
+auto sleep_and_record(timer_wheel& wheel, timer_wheel::duration d,
+                      vector<int>& records, int id) -> return_ignore
+{
+    co_await wheel.sleep_for(d);
+    records.emplace_back(id);
+}
+
+auto sleep_and_mark(timer_wheel& wheel, timer_wheel::duration d, bool& mark)
+    -> return_frame
+{
+    co_await wheel.sleep_for(d);
+    mark = true;
+}
+
+// - Note
+//      Count the resumes before the time point
+auto sleep_and_check(timer_wheel& wheel, timer_wheel::time_point until,
+                     size_t& early) -> return_ignore
+{
+    co_await wheel.sleep_until(until);
+    if (timer_wheel::clock_type::now() < until)
+        early += 1;
+}
+
+// - Note
+//      Resume expired coroutines until the count is met or timeout
+auto resume_expired(timer_wheel& wheel, size_t count,
+                    timer_wheel::duration timeout) -> size_t
+{
+    const auto until = timer_wheel::clock_type::now() + timeout;
+    array<coroutine_task_t, 8> buf{};
+    size_t resumed = 0;
+    while (resumed < count && timer_wheel::clock_type::now() < until)
+    {
+        gsl::span<coroutine_task_t> coros{buf};
+        if (wheel.expire(coros) == false)
+        {
+            this_thread::sleep_for(1ms);
+            continue;
+        }
+        for (auto coro : coros)
+            coro.resume();
+        resumed += coros.size();
+    }
+    return resumed;
+}
+
+TEST_CASE("timer wheel", "[suspend][timer]")
+{
+    timer_wheel wheel{};
+
+    SECTION("no timer")
+    {
+        REQUIRE(wheel.next_timeout() == timer_wheel::duration::max());
+
+        array<coroutine_task_t, 4> buf{};
+        gsl::span<coroutine_task_t> coros{buf};
+        REQUIRE_FALSE(wheel.expire(coros));
+        REQUIRE(coros.empty());
+    }
+
+    SECTION("expire in deadline order")
+    {
+        vector<int> records{};
+        sleep_and_record(wheel, 30ms, records, 3);
+        sleep_and_record(wheel, 10ms, records, 1);
+        sleep_and_record(wheel, 20ms, records, 2);
+        REQUIRE(records.empty());
+
+        // it must not be later than the nearest deadline
+        REQUIRE(wheel.next_timeout() <= 10ms);
+
+        REQUIRE(resume_expired(wheel, 3, 5s) == 3);
+        REQUIRE(records == vector<int>{1, 2, 3});
+        REQUIRE(wheel.next_timeout() == timer_wheel::duration::max());
+    }
+
+    SECTION("cascade from higher level")
+    {
+        // over 64 ticks. the nodes will be moved to lower levels
+        vector<int> records{};
+        sleep_and_record(wheel, 150ms, records, 2);
+        sleep_and_record(wheel, 70ms, records, 1);
+
+        const auto start = timer_wheel::clock_type::now();
+        REQUIRE(resume_expired(wheel, 2, 5s) == 2);
+        const auto elapsed = timer_wheel::clock_type::now() - start;
+
+        REQUIRE(records == vector<int>{1, 2});
+        REQUIRE(elapsed >= 140ms);
+    }
+
+    SECTION("not earlier than the time point")
+    {
+        // the time points are not aligned to the tick
+        constexpr size_t num_timer = 20;
+        size_t early = 0;
+        const auto start = timer_wheel::clock_type::now();
+        for (size_t i = 1; i <= num_timer; ++i)
+            sleep_and_check(wheel, start + i * 1ms + i * 37us, early);
+
+        REQUIRE(resume_expired(wheel, num_timer, 5s) == num_timer);
+        REQUIRE(early == 0);
+    }
+
+    SECTION("skip the idle ticks")
+    {
+        // the node is in a high level. no cascade for a long time
+        bool mark = false;
+        coroutine_task_t frame = sleep_and_mark(wheel, 1h, mark);
+        REQUIRE(wheel.next_timeout() > 1min);
+
+        vector<int> records{};
+        sleep_and_record(wheel, 80ms, records, 1);
+        REQUIRE(wheel.next_timeout() <= 80ms);
+        REQUIRE(resume_expired(wheel, 1, 5s) == 1);
+        REQUIRE(records == vector<int>{1});
+
+        REQUIRE(wheel.next_timeout() > 1min);
+        REQUIRE(mark == false);
+        frame.destroy();
+        REQUIRE(wheel.next_timeout() == timer_wheel::duration::max());
+    }
+
+    SECTION("expire to suspend queue")
+    {
+        suspend_queue sq{};
+        vector<int> records{};
+        sleep_and_record(wheel, 5ms, records, 1);
+
+        this_thread::sleep_for(20ms);
+        REQUIRE(wheel.expire(sq) == 1);
+
+        coroutine_task_t coro{};
+        REQUIRE(sq.try_pop(coro));
+        coro.resume();
+        REQUIRE(records == vector<int>{1});
+    }
+
+    SECTION("full suspend queue")
+    {
+        // more than the default capacity of the queue. push throws
+        constexpr size_t num_timer = 600;
+        suspend_queue sq{};
+        vector<int> records{};
+        for (size_t i = 0; i < num_timer; ++i)
+            sleep_and_record(wheel, 1ms, records, 1);
+        this_thread::sleep_for(20ms);
+        REQUIRE_THROWS(wheel.expire(sq));
+
+        // the others are not lost. they are delivered after the room
+        size_t resumed = 0;
+        while (resumed < num_timer)
+        {
+            coroutine_task_t coro{};
+            while (sq.try_pop(coro))
+            {
+                coro.resume();
+                ++resumed;
+            }
+            if (wheel.expire(sq) == 0)
+                break;
+        }
+        REQUIRE(resumed == num_timer);
+        REQUIRE(records.size() == num_timer);
+        REQUIRE(wheel.next_timeout() == timer_wheel::duration::max());
+    }
+
+    SECTION("cancel by frame destruction")
+    {
+        bool mark = false;
+        coroutine_task_t frame = sleep_and_mark(wheel, 10ms, mark);
+        REQUIRE(wheel.next_timeout() <= 10ms);
+
+        // the awaitable in the frame will withdraw its node
+        frame.destroy();
+        REQUIRE(wheel.next_timeout() == timer_wheel::duration::max());
+
+        this_thread::sleep_for(20ms);
+        REQUIRE(resume_expired(wheel, 1, 50ms) == 0);
+        REQUIRE(mark == false);
+    }
+
+    SECTION("past deadline doesn't suspend")
+    {
+        bool mark = false;
+        coroutine_task_t frame = sleep_and_mark(wheel, 0ms, mark);
+        REQUIRE(mark);
+        REQUIRE(frame.done());
+        frame.destroy();
+    }
+}
@@ -6,8 +6,12 @@
 #include <coroutine/suspend.h>
 #include <coroutine/sync.h>
 
+#include <array>
+#include <atomic>
 #include <gsl/gsl>
+#include <system_error>
 #include <thread>
+#include <vector>
 
 #include <CppUnitTest.h>
 
@@ -168,3 +172,390 @@ class suspend_queue_test : public TestClass<suspend_queue_test>
         w3.join();
     }
 };
+
+class suspend_queue_lock_free_test
+    : public TestClass<suspend_queue_lock_free_test>
+{
+    TEST_METHOD(suspend_queue_lock_free_no_thread)
+    {
+        suspend_queue sq{suspend_queue::mode::lock_free};
+
+        auto routine = [&sq](int& status) -> return_ignore {
+            status = 1;
+            co_await sq.wait();
+            status = 2;
+        };
+
+        int status = 0;
+        routine(status);
+        Assert::IsTrue(status == 1);
+
+        coroutine_task_t coro{};
+        Assert::IsTrue(sq.try_pop(coro));
+        coro.resume();
+        Assert::IsTrue(status == 2);
+
+        // nothing left in the queue
+        Assert::IsFalse(sq.try_pop(coro));
+    }
+
+    TEST_METHOD(suspend_queue_lock_free_multiple_worker_thread)
+    {
+        suspend_queue sq{suspend_queue::mode::lock_free};
+
+        constexpr size_t num_task = 100;
+        std::atomic<size_t> count{};
+
+        auto routine = [&sq](std::atomic<size_t>& count) -> return_ignore {
+            co_await sq.wait(); // just wait schedule
+            count += 1;
+        };
+        auto spawn = [&]() {
+            for (size_t i = 0; i < num_task; ++i)
+                routine(count);
+        };
+        auto resume_until_done = [&]() {
+            coroutine_task_t coro{};
+            while (count < 3 * num_task)
+                if (sq.try_pop(coro))
+                    coro.resume();
+                else
+                    this_thread::yield();
+        };
+
+        thread w1{resume_until_done}, w2{resume_until_done};
+        thread p1{spawn}, p2{spawn}, p3{spawn};
+
+        p1.join();
+        p2.join();
+        p3.join();
+        w1.join();
+        w2.join();
+        Assert::IsTrue(count == 3 * num_task);
+    }
+};
+
+class suspend_queue_unbounded_test
+    : public TestClass<suspend_queue_unbounded_test>
+{
+    TEST_METHOD(suspend_queue_unbounded_over_capacity)
+    {
+        suspend_queue sq{suspend_queue::mode::unbounded};
+
+        auto routine = [&sq](std::atomic<size_t>& count) -> return_ignore {
+            co_await sq.wait(); // just wait schedule
+            count += 1;
+        };
+
+        // much more than the capacity of bounded queues
+        constexpr size_t num_task = 10'000;
+        std::atomic<size_t> count{};
+
+        for (size_t i = 0; i < num_task; ++i)
+            routine(count);
+
+        coroutine_task_t coro{};
+        while (sq.try_pop(coro))
+            coro.resume();
+
+        Assert::IsTrue(count == num_task);
+    }
+};
+
+class suspend_queue_capacity_test
+    : public TestClass<suspend_queue_capacity_test>
+{
+    TEST_METHOD(suspend_queue_large_capacity)
+    {
+        suspend_queue sq{suspend_queue::mode::lock_cond, 100'000};
+
+        auto routine = [&sq](size_t& count) -> return_ignore {
+            co_await sq.wait(); // just wait schedule
+            count += 1;
+        };
+
+        constexpr size_t num_task = 100'000;
+        size_t count = 0;
+        for (size_t i = 0; i < num_task; ++i)
+            routine(count);
+
+        coroutine_task_t coro{};
+        while (sq.try_pop(coro))
+            coro.resume();
+        Assert::IsTrue(count == num_task);
+    }
+};
+
+class suspend_queue_batch_test : public TestClass<suspend_queue_batch_test>
+{
+    TEST_METHOD(suspend_queue_push_n_try_pop_n)
+    {
+        suspend_queue sq{};
+
+        auto routine = [](suspend_hook& hook, size_t& count) -> return_ignore {
+            co_await hook;
+            count += 1;
+        };
+
+        size_t count = 0;
+        std::array<suspend_hook, 20> hooks{};
+        std::array<coroutine_task_t, 20> tasks{};
+        for (size_t i = 0; i < hooks.size(); ++i)
+        {
+            routine(hooks[i], count);
+            tasks[i] = hooks[i];
+        }
+        sq.push_n(tasks);
+
+        std::array<coroutine_task_t, 15> buf{};
+        gsl::span<coroutine_task_t> popped{buf};
+        Assert::IsTrue(sq.try_pop_n(popped));
+        Assert::IsTrue(popped.size() == 15); // limited by the span
+        for (auto coro : popped)
+            coro.resume();
+
+        popped = buf;
+        Assert::IsTrue(sq.try_pop_n(popped));
+        Assert::IsTrue(popped.size() == 5); // remaining coroutines
+        for (auto coro : popped)
+            coro.resume();
+
+        Assert::IsTrue(count == 20);
+    }
+};
+
+class suspend_queue_wait_test : public TestClass<suspend_queue_wait_test>
+{
+    TEST_METHOD(suspend_queue_wait_pop_timeout)
+    {
+        suspend_queue sq{};
+        coroutine_task_t coro{};
+
+        const auto start = chrono::steady_clock::now();
+        Assert::IsFalse(sq.wait_pop(coro, 200ms));
+        Assert::IsTrue(chrono::steady_clock::now() - start >= 199ms);
+    }
+
+    TEST_METHOD(suspend_queue_wait_pop_wake_up_by_push)
+    {
+        suspend_queue sq{};
+
+        using thread_id_t = std::thread::id;
+        auto routine = [&sq](thread_id_t& invoke_id,
+                             thread_id_t& resume_id) -> return_ignore {
+            invoke_id = this_thread::get_id();
+            co_await sq.wait();
+            resume_id = this_thread::get_id();
+        };
+
+        const auto start = chrono::steady_clock::now();
+        thread worker{[&sq]() {
+            coroutine_task_t coro{};
+            if (sq.wait_pop(coro, 10s))
+                coro.resume();
+        }};
+
+        this_thread::sleep_for(100ms);
+        thread_id_t id1{}, id2{};
+        routine(id1, id2);
+        worker.join();
+
+        Assert::IsTrue(chrono::steady_clock::now() - start < 10s);
+        Assert::IsTrue(id1 != id2);
+        Assert::IsTrue(id1 == this_thread::get_id());
+    }
+};
+
+class suspend_queue_priority_test
+    : public TestClass<suspend_queue_priority_test>
+{
+    TEST_METHOD(suspend_queue_priority_urgent_first)
+    {
+        suspend_queue sq{suspend_queue::mode::priority};
+
+        auto routine = [&sq](uint32_t priority,
+                             std::vector<uint32_t>& order) -> return_ignore {
+            co_await sq.wait(priority);
+            order.emplace_back(priority);
+        };
+
+        std::vector<uint32_t> order{};
+        for (auto priority : {7u, 0u, 3u, 0u, 5u})
+            routine(priority, order);
+
+        coroutine_task_t coro{};
+        while (sq.try_pop(coro))
+            coro.resume();
+
+        Assert::IsTrue(order == std::vector<uint32_t>{0, 0, 3, 5, 7});
+    }
+
+    TEST_METHOD(suspend_queue_priority_no_starvation)
+    {
+        suspend_queue sq{suspend_queue::mode::priority};
+
+        auto routine = [&sq](uint32_t priority,
+                             std::vector<uint32_t>& order) -> return_ignore {
+            co_await sq.wait(priority);
+            order.emplace_back(priority);
+        };
+
+        std::vector<uint32_t> order{};
+        routine(suspend_queue::priority_levels - 1, order);
+        for (auto i = 0; i < 100; ++i)
+            routine(0, order);
+
+        coroutine_task_t coro{};
+        while (sq.try_pop(coro))
+            coro.resume();
+
+        Assert::IsTrue(order.size() == 101);
+        Assert::IsTrue(order.back() == 0);
+    }
+
+    TEST_METHOD(suspend_queue_sharded_locality)
+    {
+        suspend_queue sq{suspend_queue::mode::sharded};
+
+        auto routine = [&sq](std::atomic<size_t>& count) -> return_ignore {
+            co_await sq.wait(); // just wait schedule
+            count += 1;
+        };
+
+        constexpr size_t num_task = 1000;
+        const auto num_thread = std::max(2u, thread::hardware_concurrency());
+        std::atomic<size_t> count{};
+
+        auto run = [&](uint32_t cpu) {
+            pin_current_thread(cpu);
+            for (size_t i = 0; i < num_task; ++i)
+                routine(count);
+
+            coroutine_task_t coro{};
+            while (count < num_thread * num_task)
+                if (sq.try_pop(coro))
+                    coro.resume();
+                else
+                    this_thread::yield();
+        };
+
+        std::vector<thread> threads{};
+        for (uint32_t cpu = 0; cpu < num_thread; ++cpu)
+            threads.emplace_back(run, cpu);
+        for (auto& t : threads)
+            t.join();
+        Assert::IsTrue(count == num_thread * num_task);
+
+        uint64_t local = 0, remote = 0;
+        Assert::IsTrue(sq.locality(local, remote));
+        Assert::IsTrue(local + remote == num_thread * num_task);
+        Assert::IsTrue(local > 0);
+    }
+
+    TEST_METHOD(suspend_queue_no_locality_for_other_modes)
+    {
+        suspend_queue sq{};
+        uint64_t local = 1, remote = 1;
+        Assert::IsFalse(sq.locality(local, remote));
+        Assert::IsTrue(local == 0 && remote == 0);
+    }
+
+    TEST_METHOD(suspend_queue_spsc_one_producer_one_consumer)
+    {
+        suspend_queue sq{suspend_queue::mode::spsc};
+
+        auto routine = [&sq](std::atomic<size_t>& count) -> return_ignore {
+            co_await sq.wait(); // just wait schedule
+            count += 1;
+        };
+
+        constexpr size_t num_chunk = 100, chunk_size = 1000;
+        std::atomic<size_t> count{};
+        thread consumer{[&sq, &count]() {
+            coroutine_task_t coro{};
+            while (count < num_chunk * chunk_size)
+                if (sq.wait_pop(coro, 1s))
+                    coro.resume();
+        }};
+        for (size_t c = 1; c <= num_chunk; ++c)
+        {
+            for (size_t i = 0; i < chunk_size; ++i)
+                routine(count);
+            while (count < c * chunk_size)
+                this_thread::yield();
+        }
+        consumer.join();
+        Assert::IsTrue(count == num_chunk * chunk_size);
+    }
+
+    TEST_METHOD(suspend_queue_event_mode_not_supported)
+    {
+        // the mode requires Linux eventfd
+        Assert::ExpectException<std::system_error>([]() {
+            suspend_queue sq{suspend_queue::mode::event}; //
+        });
+    }
+
+    TEST_METHOD(suspend_queue_stats_snapshot)
+    {
+        suspend_queue sq{};
+        suspend_queue_stats stats{};
+
+        // the frames are never resumed. use fake addresses
+        std::array<coroutine_task_t, 10> tasks{};
+        for (size_t i = 0; i < tasks.size(); ++i)
+            tasks[i] = coroutine_task_t::from_address(&tasks[i]);
+        sq.push_n(tasks);
+
+        coroutine_task_t coro{};
+        while (sq.try_pop(coro))
+            continue;
+
+#if !defined(USE_SUSPEND_QUEUE_STATS)
+        Assert::IsFalse(sq.snapshot(stats));
+        Assert::IsTrue(stats.push_count == 0);
+#else
+        Assert::IsTrue(sq.snapshot(stats));
+        Assert::IsTrue(stats.push_count == 10);
+        Assert::IsTrue(stats.pop_count == 10);
+#endif
+    }
+
+    TEST_METHOD(suspend_queue_resume_batch_limited_by_count)
+    {
+        suspend_queue sq{};
+        size_t count = 0;
+
+        auto routine = [&sq](size_t& count) -> return_ignore {
+            co_await sq.wait(); // just wait schedule
+            count += 1;
+        };
+        for (auto i = 0; i < 25; ++i)
+            routine(count);
+
+        Assert::IsTrue(sq.resume_batch(10, 1s) == 10);
+        Assert::IsTrue(count == 10);
+        Assert::IsTrue(sq.resume_batch(10, 1s) == 10);
+        Assert::IsTrue(sq.resume_batch(10, 1s) == 5);
+        Assert::IsTrue(count == 25);
+    }
+
+    TEST_METHOD(suspend_queue_resume_batch_limited_by_time)
+    {
+        suspend_queue sq{};
+        size_t count = 0;
+
+        auto routine = [&sq](size_t& count) -> return_ignore {
+            co_await sq.wait();
+            this_thread::sleep_for(10ms);
+            count += 1;
+        };
+        for (auto i = 0; i < 10; ++i)
+            routine(count);
+
+        const auto n = sq.resume_batch(100, 25ms);
+        Assert::IsTrue(n >= 1 && n < 10);
+        Assert::IsTrue(sq.resume_batch(100, 10s) == 10 - n);
+        Assert::IsTrue(count == 10);
+    }
+};
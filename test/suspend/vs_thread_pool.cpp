@@ -0,0 +1,85 @@
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+#include <coroutine/return.h>
+#include <coroutine/suspend.h>
+#include <coroutine/sync.h>
+
+#include <atomic>
+#include <thread>
+
+#include <CppUnitTest.h>
+
+using namespace std;
+using namespace std::literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+class thread_pool_test : public TestClass<thread_pool_test>
+{
+    TEST_METHOD(thread_pool_schedule_to_worker)
+    {
+        thread_pool pool{4};
+        wait_group wg{};
+        wg.add(1);
+
+        using thread_id_t = std::thread::id;
+
+        auto routine = [&pool](wait_group& wg, thread_id_t& invoke_id,
+                               thread_id_t& resume_id) -> return_ignore {
+            invoke_id = this_thread::get_id();
+            co_await pool.schedule();
+            resume_id = this_thread::get_id();
+            wg.done();
+        };
+
+        thread_id_t id1{}, id2{};
+        routine(wg, id1, id2);
+
+        Assert::IsTrue(wg.wait(10s));
+        Assert::IsTrue(id1 == this_thread::get_id());
+        Assert::IsTrue(id1 != id2);
+    }
+
+    TEST_METHOD(thread_pool_reschedule_in_worker)
+    {
+        thread_pool pool{4};
+
+        constexpr uint16_t num_task = 1000;
+        std::atomic<size_t> count{};
+        wait_group wg{};
+        wg.add(num_task);
+
+        auto routine = [&pool](wait_group& wg,
+                               std::atomic<size_t>& count) -> return_ignore {
+            for (auto i = 0; i < 10; ++i)
+            {
+                co_await pool.schedule();
+                count += 1;
+            }
+            wg.done();
+        };
+        for (auto i = 0; i < num_task; ++i)
+            routine(wg, count);
+
+        Assert::IsTrue(wg.wait(10s));
+        Assert::IsTrue(count == num_task * 10);
+    }
+
+    TEST_METHOD(thread_pool_destruction)
+    {
+        std::atomic<size_t> count{};
+
+        auto routine = [](thread_pool& pool,
+                          std::atomic<size_t>& count) -> return_ignore {
+            co_await pool.schedule();
+            count += 1;
+        };
+        {
+            thread_pool pool{2};
+            for (auto i = 0; i < 100; ++i)
+                routine(pool, count);
+        }
+        Assert::IsTrue(count == 100);
+    }
+};
@@ -0,0 +1,95 @@
+//
+//  Author  : github.com/luncliff (luncliff@gmail.com)
+//  License : CC BY 4.0
+//
+#include <coroutine/return.h>
+#include <coroutine/suspend.h>
+
+#include <array>
+#include <thread>
+#include <vector>
+
+#include <CppUnitTest.h>
+
+using namespace std;
+using namespace std::literals;
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+class timer_wheel_test : public TestClass<timer_wheel_test>
+{
+    static auto sleep_and_record(timer_wheel& wheel, timer_wheel::duration d,
+                                 vector<int>& records, int id)
+        -> return_ignore
+    {
+        co_await wheel.sleep_for(d);
+        records.emplace_back(id);
+    }
+
+    static auto sleep_and_mark(timer_wheel& wheel, timer_wheel::duration d,
+                               bool& mark) -> return_frame
+    {
+        co_await wheel.sleep_for(d);
+        mark = true;
+    }
+
+    static auto resume_expired(timer_wheel& wheel, size_t count,
+                               timer_wheel::duration timeout) -> size_t
+    {
+        const auto until = timer_wheel::clock_type::now() + timeout;
+        array<coroutine_task_t, 8> buf{};
+        size_t resumed = 0;
+        while (resumed < count && timer_wheel::clock_type::now() < until)
+        {
+            gsl::span<coroutine_task_t> coros{buf};
+            if (wheel.expire(coros) == false)
+            {
+                this_thread::sleep_for(1ms);
+                continue;
+            }
+            for (auto coro : coros)
+                coro.resume();
+            resumed += coros.size();
+        }
+        return resumed;
+    }
+
+    TEST_METHOD(timer_wheel_expire_in_deadline_order)
+    {
+        timer_wheel wheel{};
+        vector<int> records{};
+        sleep_and_record(wheel, 30ms, records, 3);
+        sleep_and_record(wheel, 10ms, records, 1);
+        sleep_and_record(wheel, 20ms, records, 2);
+        Assert::IsTrue(records.empty());
+        Assert::IsTrue(wheel.next_timeout() <= 10ms);
+
+        Assert::IsTrue(resume_expired(wheel, 3, 5s) == 3);
+        Assert::IsTrue(records == vector<int>{1, 2, 3});
+        Assert::IsTrue(wheel.next_timeout() == timer_wheel::duration::max());
+    }
+
+    TEST_METHOD(timer_wheel_cascade_from_higher_level)
+    {
+        timer_wheel wheel{};
+        vector<int> records{};
+        sleep_and_record(wheel, 150ms, records, 2);
+        sleep_and_record(wheel, 70ms, records, 1);
+
+        Assert::IsTrue(resume_expired(wheel, 2, 5s) == 2);
+        Assert::IsTrue(records == vector<int>{1, 2});
+    }
+
+    TEST_METHOD(timer_wheel_cancel_by_frame_destruction)
+    {
+        timer_wheel wheel{};
+        bool mark = false;
+        coroutine_task_t frame = sleep_and_mark(wheel, 10ms, mark);
+
+        frame.destroy();
+        Assert::IsTrue(wheel.next_timeout() == timer_wheel::duration::max());
+
+        this_thread::sleep_for(20ms);
+        Assert::IsTrue(resume_expired(wheel, 1, 50ms) == 0);
+        Assert::IsFalse(mark);
+    }
+};